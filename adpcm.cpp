@@ -0,0 +1,101 @@
+#include "adpcm.h"
+
+static const int INDEX_TABLE[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+// Apply 'nibble' to the channel's state; the encoder and decoder share this so they stay in step
+static int apply_nibble(AdpcmChannel *channel, int nibble) {
+    const int step = STEP_TABLE[channel->index];
+    int delta = step >> 3;
+    if (nibble & 4) {
+        delta += step;
+    }
+    if (nibble & 2) {
+        delta += step >> 1;
+    }
+    if (nibble & 1) {
+        delta += step >> 2;
+    }
+    channel->predictor += (nibble & 8) ? -delta : delta;
+    channel->predictor = SDL_clamp(channel->predictor, -32768, 32767);
+    channel->index = SDL_clamp(channel->index + INDEX_TABLE[nibble], 0, 88);
+    return channel->predictor;
+}
+
+static int encode_sample(AdpcmChannel *channel, int sample) {
+    int step = STEP_TABLE[channel->index];
+    int diff = sample - channel->predictor;
+    int nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+    if (diff >= step) {
+        nibble |= 4;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 2;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 1;
+    }
+    apply_nibble(channel, nibble);
+    return nibble;
+}
+
+int adpcm_block_size(int channels) {
+    return channels * 4 + ADPCM_BLOCK_FRAMES * channels / 2;
+}
+
+void adpcm_encode_block(const Sint16 *in, int frames, int channels, AdpcmChannel *state, Uint8 *out) {
+    for (int c = 0; c < channels; c++) {
+        const Uint16 predictor = (Uint16) state[c].predictor;
+        out[0] = (Uint8) (predictor & 0xFF);
+        out[1] = (Uint8) (predictor >> 8);
+        out[2] = (Uint8) state[c].index;
+        out[3] = 0;
+        out += 4;
+    }
+
+    const int samples = ADPCM_BLOCK_FRAMES * channels;
+    for (int i = 0; i < samples; i++) {
+        const int sample = (i < frames * channels) ? in[i] : 0;
+        const int nibble = encode_sample(&state[i % channels], sample);
+        if (i & 1) {
+            out[i / 2] |= (Uint8) (nibble << 4);
+        } else {
+            out[i / 2] = (Uint8) nibble;
+        }
+    }
+}
+
+void adpcm_decode_block(const Uint8 *in, int channels, Sint16 *out) {
+    AdpcmChannel state[8];
+    channels = SDL_min(channels, (int) SDL_arraysize(state));
+    for (int c = 0; c < channels; c++) {
+        state[c].predictor = (Sint16) (in[0] | (in[1] << 8));
+        state[c].index = SDL_min(in[2], 88);
+        in += 4;
+    }
+
+    const int samples = ADPCM_BLOCK_FRAMES * channels;
+    for (int i = 0; i < samples; i++) {
+        const int nibble = (i & 1) ? (in[i / 2] >> 4) : (in[i / 2] & 0x0F);
+        out[i] = (Sint16) apply_nibble(&state[i % channels], nibble);
+    }
+}
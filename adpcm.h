@@ -0,0 +1,31 @@
+/* IMA ADPCM, 4 bits per sample, in independent blocks so any block can be decoded on its
+ * own (music loops back to block 0; nothing else seeks).
+ *
+ * Block layout for 'channels' interleaved channels:
+ *   per channel  S16 predictor, U8 step index, U8 0     (state before the first sample)
+ *   samples      ADPCM_BLOCK_FRAMES * channels nibbles, interleaved like PCM, low nibble first
+ */
+
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#include <SDL3/SDL.h>
+
+const int ADPCM_BLOCK_FRAMES = 1024;
+
+// Encoder state of one channel, carried from block to block
+typedef struct AdpcmChannel {
+    int predictor;
+    int index;
+} AdpcmChannel;
+
+// Bytes in one block
+int adpcm_block_size(int channels);
+
+// Encode up to ADPCM_BLOCK_FRAMES frames of 'in'; a short last block is padded with silence
+void adpcm_encode_block(const Sint16 *in, int frames, int channels, AdpcmChannel *state, Uint8 *out);
+
+// Decode one whole block into ADPCM_BLOCK_FRAMES frames of 'out'
+void adpcm_decode_block(const Uint8 *in, int channels, Sint16 *out);
+
+#endif
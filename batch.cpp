@@ -0,0 +1,314 @@
+#include "batch.h"
+#include <SDL3/SDL_intrin.h>
+
+/* Hand out the next 'capacity' elements of the batch allocation */
+template <typename T>
+static T *take_array(Uint8 **next, int capacity) {
+    T *array = (T *) *next;
+    *next += capacity * sizeof(T);
+    return array;
+}
+
+bool batch_create(MatchBatch *batch, int count) {
+    SDL_zerop(batch);
+
+    const int capacity = ((count + BATCH_MAX_WIDTH - 1) / BATCH_MAX_WIDTH) * BATCH_MAX_WIDTH;
+    const size_t bytes = capacity * (12 * sizeof(float) + 3 * sizeof(int) + sizeof(Uint64));
+
+    // Every array starts on a 32 byte boundary since capacity is a multiple of 8 lanes
+    Uint8 *memory = (Uint8 *) SDL_aligned_alloc(32, bytes);
+    if (!memory) {
+        return false;
+    }
+    SDL_memset(memory, 0, bytes);
+
+    batch->count = count;
+    batch->capacity = capacity;
+    batch->memory = memory;
+
+    Uint8 *next = memory;
+    batch->ball_speed_multiplier = take_array<float>(&next, capacity);
+    batch->paddle_speed_multiplier = take_array<float>(&next, capacity);
+    batch->cpu_speed = take_array<float>(&next, capacity);
+    batch->position_player_y = take_array<float>(&next, capacity);
+    batch->position_cpu_y = take_array<float>(&next, capacity);
+    batch->position_ball_x = take_array<float>(&next, capacity);
+    batch->position_ball_y = take_array<float>(&next, capacity);
+    batch->component_ball_x = take_array<float>(&next, capacity);
+    batch->direction_player = take_array<float>(&next, capacity);
+    batch->direction_cpu = take_array<float>(&next, capacity);
+    batch->direction_ball_x = take_array<float>(&next, capacity);
+    batch->direction_ball_y = take_array<float>(&next, capacity);
+    batch->score_player = take_array<int>(&next, capacity);
+    batch->score_cpu = take_array<int>(&next, capacity);
+    batch->events = take_array<int>(&next, capacity);
+    batch->rng_state = take_array<Uint64>(&next, capacity);
+
+    // Padding lanes get valid state too, so the kernel can step them harmlessly
+    MatchConfig config;
+    match_default_config(&config);
+    Match match;
+    match_init(&match, &config, 0);
+    for (int i = 0; i < capacity; i++) {
+        batch_set_match(batch, i, &match);
+    }
+    batch->count = count;
+    return true;
+}
+
+void batch_destroy(MatchBatch *batch) {
+    SDL_aligned_free(batch->memory);
+    SDL_zerop(batch);
+}
+
+void batch_set_match(MatchBatch *batch, int index, const Match *match) {
+    batch->ball_speed_multiplier[index] = match->config.ball_speed_multiplier;
+    batch->paddle_speed_multiplier[index] = match->config.paddle_speed_multiplier;
+    batch->cpu_speed[index] = match->config.cpu_speed;
+    batch->position_player_y[index] = match->position_player_y;
+    batch->position_cpu_y[index] = match->position_cpu_y;
+    batch->position_ball_x[index] = match->position_ball_x;
+    batch->position_ball_y[index] = match->position_ball_y;
+    batch->component_ball_x[index] = match->component_ball_x;
+    batch->direction_player[index] = (float) match->direction_player;
+    batch->direction_cpu[index] = (float) match->direction_cpu;
+    batch->direction_ball_x[index] = (float) match->direction_ball_x;
+    batch->direction_ball_y[index] = (float) match->direction_ball_y;
+    batch->score_player[index] = match->score_player;
+    batch->score_cpu[index] = match->score_cpu;
+    batch->events[index] = MATCH_EVENT_NONE;
+    batch->rng_state[index] = match->rng_state;
+}
+
+void batch_get_match(const MatchBatch *batch, int index, Match *match) {
+    match->config.ball_speed_multiplier = batch->ball_speed_multiplier[index];
+    match->config.paddle_speed_multiplier = batch->paddle_speed_multiplier[index];
+    match->config.cpu_speed = batch->cpu_speed[index];
+    match->config.cpu_control = CPU_PING_PONG;
+    match->config.cpu_reaction = 0;
+    match->config.cpu_error = 0;
+    match->position_player_y = batch->position_player_y[index];
+    match->position_cpu_y = batch->position_cpu_y[index];
+    match->position_ball_x = batch->position_ball_x[index];
+    match->position_ball_y = batch->position_ball_y[index];
+    match->component_ball_x = batch->component_ball_x[index];
+    match->direction_player = static_cast<Directions>((int) batch->direction_player[index]);
+    match->direction_cpu = static_cast<Directions>((int) batch->direction_cpu[index]);
+    match->direction_ball_x = static_cast<Directions>((int) batch->direction_ball_x[index]);
+    match->direction_ball_y = static_cast<Directions>((int) batch->direction_ball_y[index]);
+    match->score_player = batch->score_player[index];
+    match->score_cpu = batch->score_cpu[index];
+    match->cpu_target_y = GAME_HEIGHT/2;
+    match->cpu_think_time = 0;
+    match->rng_state = batch->rng_state[index];
+}
+
+void batch_autoplay(MatchBatch *batch) {
+    for (int i = 0; i < batch->count; i++) {
+        // Same rule as match_autoplay_direction()
+        float paddle_centre = batch->position_player_y[i] + PADDLE_HEIGHT/2;
+        float ball_centre = batch->position_ball_y[i] + BALL_SIZE/2;
+        float direction = ZERO;
+        if (ball_centre < paddle_centre - 8) {
+            direction = UP;
+        } else if (ball_centre > paddle_centre + 8) {
+            direction = DOWN;
+        }
+        batch->direction_player[i] = direction;
+    }
+}
+
+/* A point was scored in lane 'index': serve again exactly as match_step() does */
+static void serve_lane(MatchBatch *batch, int index) {
+    if (batch->position_ball_x[index] < -20) {
+        batch->score_cpu[index]++;
+        batch->events[index] |= MATCH_EVENT_SCORE_CPU;
+    } else {
+        batch->score_player[index]++;
+        batch->events[index] |= MATCH_EVENT_SCORE_PLAYER;
+    }
+    batch->position_ball_x[index] = GAME_WIDTH/2;
+    batch->position_ball_y[index] = SDL_rand_r(&batch->rng_state[index], (int) (GAME_HEIGHT - BALL_SIZE));
+    batch->component_ball_x[index] = SDL_randf_r(&batch->rng_state[index]);
+    batch->direction_ball_x[index] = UP;
+}
+
+/* One lane at a time; also the fallback on CPUs without SSE2 */
+struct ScalarOps {
+    typedef float V;
+    typedef bool M;
+    typedef int I;
+    static const int WIDTH = 1;
+
+    static inline V load(const float *p) { return *p; }
+    static inline void store(float *p, V v) { *p = v; }
+    static inline void store_int(int *p, I v) { *p = v; }
+    static inline V set1(float f) { return f; }
+    static inline V add(V a, V b) { return a + b; }
+    static inline V sub(V a, V b) { return a - b; }
+    static inline V mul(V a, V b) { return a * b; }
+    static inline V div(V a, V b) { return a / b; }
+    static inline V max(V a, V b) { return a > b ? a : b; }
+    static inline M lt(V a, V b) { return a < b; }
+    static inline M le(V a, V b) { return a <= b; }
+    static inline M gt(V a, V b) { return a > b; }
+    static inline M ge(V a, V b) { return a >= b; }
+    static inline M eq(V a, V b) { return a == b; }
+    static inline M ne(V a, V b) { return a != b; }
+    static inline M and_mask(M a, M b) { return a && b; }
+    static inline M or_mask(M a, M b) { return a || b; }
+    static inline V select(M m, V a, V b) { return m ? a : b; }
+    static inline int movemask(M m) { return m ? 1 : 0; }
+    static inline I bits(M m, int bit) { return m ? bit : 0; }
+    static inline I ior(I a, I b) { return a | b; }
+    static inline M true_mask() { return true; }
+    static inline I zero_int() { return 0; }
+};
+
+#define BATCH_OPS ScalarOps
+#define BATCH_KERNEL_NAME batch_step_scalar
+#define BATCH_KERNEL_TARGET
+#include "batch_kernel.inl"
+#undef BATCH_OPS
+#undef BATCH_KERNEL_NAME
+#undef BATCH_KERNEL_TARGET
+
+#ifdef SDL_SSE2_INTRINSICS
+struct Sse2Ops {
+    typedef __m128 V;
+    typedef __m128 M;
+    typedef __m128i I;
+    static const int WIDTH = 4;
+
+    SDL_TARGETING("sse2") static inline V load(const float *p) { return _mm_load_ps(p); }
+    SDL_TARGETING("sse2") static inline void store(float *p, V v) { _mm_store_ps(p, v); }
+    SDL_TARGETING("sse2") static inline void store_int(int *p, I v) { _mm_store_si128((__m128i *) p, v); }
+    SDL_TARGETING("sse2") static inline V set1(float f) { return _mm_set1_ps(f); }
+    SDL_TARGETING("sse2") static inline V add(V a, V b) { return _mm_add_ps(a, b); }
+    SDL_TARGETING("sse2") static inline V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    SDL_TARGETING("sse2") static inline V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    SDL_TARGETING("sse2") static inline V div(V a, V b) { return _mm_div_ps(a, b); }
+    SDL_TARGETING("sse2") static inline V max(V a, V b) { return _mm_max_ps(a, b); }
+    SDL_TARGETING("sse2") static inline M lt(V a, V b) { return _mm_cmplt_ps(a, b); }
+    SDL_TARGETING("sse2") static inline M le(V a, V b) { return _mm_cmple_ps(a, b); }
+    SDL_TARGETING("sse2") static inline M gt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+    SDL_TARGETING("sse2") static inline M ge(V a, V b) { return _mm_cmpge_ps(a, b); }
+    SDL_TARGETING("sse2") static inline M eq(V a, V b) { return _mm_cmpeq_ps(a, b); }
+    SDL_TARGETING("sse2") static inline M ne(V a, V b) { return _mm_cmpneq_ps(a, b); }
+    SDL_TARGETING("sse2") static inline M and_mask(M a, M b) { return _mm_and_ps(a, b); }
+    SDL_TARGETING("sse2") static inline M or_mask(M a, M b) { return _mm_or_ps(a, b); }
+    SDL_TARGETING("sse2") static inline V select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    SDL_TARGETING("sse2") static inline int movemask(M m) { return _mm_movemask_ps(m); }
+    SDL_TARGETING("sse2") static inline I bits(M m, int bit) { return _mm_and_si128(_mm_castps_si128(m), _mm_set1_epi32(bit)); }
+    SDL_TARGETING("sse2") static inline I ior(I a, I b) { return _mm_or_si128(a, b); }
+    SDL_TARGETING("sse2") static inline M true_mask() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+    SDL_TARGETING("sse2") static inline I zero_int() { return _mm_setzero_si128(); }
+};
+
+#define BATCH_OPS Sse2Ops
+#define BATCH_KERNEL_NAME batch_step_sse2
+#define BATCH_KERNEL_TARGET SDL_TARGETING("sse2")
+#include "batch_kernel.inl"
+#undef BATCH_OPS
+#undef BATCH_KERNEL_NAME
+#undef BATCH_KERNEL_TARGET
+#endif
+
+#ifdef SDL_AVX2_INTRINSICS
+struct Avx2Ops {
+    typedef __m256 V;
+    typedef __m256 M;
+    typedef __m256i I;
+    static const int WIDTH = 8;
+
+    SDL_TARGETING("avx2") static inline V load(const float *p) { return _mm256_load_ps(p); }
+    SDL_TARGETING("avx2") static inline void store(float *p, V v) { _mm256_store_ps(p, v); }
+    SDL_TARGETING("avx2") static inline void store_int(int *p, I v) { _mm256_store_si256((__m256i *) p, v); }
+    SDL_TARGETING("avx2") static inline V set1(float f) { return _mm256_set1_ps(f); }
+    SDL_TARGETING("avx2") static inline V add(V a, V b) { return _mm256_add_ps(a, b); }
+    SDL_TARGETING("avx2") static inline V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    SDL_TARGETING("avx2") static inline V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    SDL_TARGETING("avx2") static inline V div(V a, V b) { return _mm256_div_ps(a, b); }
+    SDL_TARGETING("avx2") static inline V max(V a, V b) { return _mm256_max_ps(a, b); }
+    SDL_TARGETING("avx2") static inline M lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    SDL_TARGETING("avx2") static inline M le(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    SDL_TARGETING("avx2") static inline M gt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    SDL_TARGETING("avx2") static inline M ge(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    SDL_TARGETING("avx2") static inline M eq(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    SDL_TARGETING("avx2") static inline M ne(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+    SDL_TARGETING("avx2") static inline M and_mask(M a, M b) { return _mm256_and_ps(a, b); }
+    SDL_TARGETING("avx2") static inline M or_mask(M a, M b) { return _mm256_or_ps(a, b); }
+    SDL_TARGETING("avx2") static inline V select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+    SDL_TARGETING("avx2") static inline int movemask(M m) { return _mm256_movemask_ps(m); }
+    SDL_TARGETING("avx2") static inline I bits(M m, int bit) { return _mm256_and_si256(_mm256_castps_si256(m), _mm256_set1_epi32(bit)); }
+    SDL_TARGETING("avx2") static inline I ior(I a, I b) { return _mm256_or_si256(a, b); }
+    SDL_TARGETING("avx2") static inline M true_mask() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+    SDL_TARGETING("avx2") static inline I zero_int() { return _mm256_setzero_si256(); }
+};
+
+#define BATCH_OPS Avx2Ops
+#define BATCH_KERNEL_NAME batch_step_avx2
+#define BATCH_KERNEL_TARGET SDL_TARGETING("avx2")
+#include "batch_kernel.inl"
+#undef BATCH_OPS
+#undef BATCH_KERNEL_NAME
+#undef BATCH_KERNEL_TARGET
+#endif
+
+bool batch_isa_supported(BatchIsa isa) {
+    switch (isa) {
+        case BATCH_ISA_SCALAR:
+            return true;
+        case BATCH_ISA_SSE2:
+#ifdef SDL_SSE2_INTRINSICS
+            return SDL_HasSSE2();
+#else
+            return false;
+#endif
+        case BATCH_ISA_AVX2:
+#ifdef SDL_AVX2_INTRINSICS
+            return SDL_HasAVX2();
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+BatchIsa batch_best_isa(void) {
+    if (batch_isa_supported(BATCH_ISA_AVX2)) {
+        return BATCH_ISA_AVX2;
+    } else if (batch_isa_supported(BATCH_ISA_SSE2)) {
+        return BATCH_ISA_SSE2;
+    }
+    return BATCH_ISA_SCALAR;
+}
+
+const char *batch_isa_name(BatchIsa isa) {
+    switch (isa) {
+        case BATCH_ISA_SCALAR:
+            return "scalar";
+        case BATCH_ISA_SSE2:
+            return "sse2";
+        case BATCH_ISA_AVX2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+void batch_step(MatchBatch *batch, float dt, BatchIsa isa) {
+    switch (isa) {
+#ifdef SDL_AVX2_INTRINSICS
+        case BATCH_ISA_AVX2:
+            batch_step_avx2(batch, dt);
+            break;
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+        case BATCH_ISA_SSE2:
+            batch_step_sse2(batch, dt);
+            break;
+#endif
+        default:
+            batch_step_scalar(batch, dt);
+    }
+}
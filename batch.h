@@ -0,0 +1,71 @@
+/* Many matches stepped together: state kept as structure-of-arrays so one SIMD kernel
+ * advances several matches per instruction. Each lane follows exactly the rules of
+ * match_step() and gives bit-identical results, provided the build doesn't contract
+ * multiply/add pairs into FMA (-ffp-contract=off).
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <SDL3/SDL.h>
+#include "match.h"
+
+// Widest vector we step with (AVX2, 8 floats); arrays are padded to a multiple of this
+const int BATCH_MAX_WIDTH = 8;
+
+typedef enum BatchIsa {
+    BATCH_ISA_SCALAR = 0,
+    BATCH_ISA_SSE2 = 1,
+    BATCH_ISA_AVX2 = 2
+} BatchIsa;
+
+typedef struct MatchBatch {
+    int count;      // Matches in use
+    int capacity;   // Allocated lanes, a multiple of BATCH_MAX_WIDTH
+
+    // Per-match MatchConfig
+    float *ball_speed_multiplier;
+    float *paddle_speed_multiplier;
+    float *cpu_speed;
+
+    float *position_player_y;
+    float *position_cpu_y;
+    float *position_ball_x;
+    float *position_ball_y;
+    float *component_ball_x;
+
+    // Directions stored as -1.0, 0.0 or 1.0 so they take part in vector maths
+    float *direction_player;    // Player input for the next step
+    float *direction_cpu;
+    float *direction_ball_x;
+    float *direction_ball_y;
+
+    int *score_player;
+    int *score_cpu;
+    int *events;    // MatchEvent mask produced by the last step
+
+    Uint64 *rng_state;
+
+    void *memory;   // Single allocation backing the arrays above
+} MatchBatch;
+
+// Allocate a batch of 'count' matches; all lanes start as match_init() with a zero seed
+bool batch_create(MatchBatch *batch, int count);
+void batch_destroy(MatchBatch *batch);
+
+// Copy a Match into or out of lane 'index'
+void batch_set_match(MatchBatch *batch, int index, const Match *match);
+void batch_get_match(const MatchBatch *batch, int index, Match *match);
+
+// Best instruction set this CPU supports, and a printable name for one
+BatchIsa batch_best_isa(void);
+bool batch_isa_supported(BatchIsa isa);
+const char *batch_isa_name(BatchIsa isa);
+
+// Set every lane's player input from match_autoplay_direction()
+void batch_autoplay(MatchBatch *batch);
+
+// Advance every match by 'dt' seconds using 'isa' (must be supported)
+void batch_step(MatchBatch *batch, float dt, BatchIsa isa);
+
+#endif
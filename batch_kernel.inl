@@ -0,0 +1,192 @@
+/* Body of the batched step, included by batch.cpp once per instruction set with:
+ *   BATCH_OPS           struct of vector operations (see ScalarOps in batch.cpp)
+ *   BATCH_KERNEL_NAME   name of the function to define
+ *   BATCH_KERNEL_TARGET function attribute enabling the instruction set (may be empty)
+ *
+ * Every operation mirrors match_step() in the same order, so each lane comes out
+ * bit-identical to the scalar rules. Random draws (stuck-ball reroll and serves) are
+ * rare and done per lane in plain code.
+ */
+
+BATCH_KERNEL_TARGET static void BATCH_KERNEL_NAME(MatchBatch *batch, float dt) {
+    typedef BATCH_OPS Ops;
+    typedef Ops::V V;
+    typedef Ops::M M;
+    typedef Ops::I I;
+    const int width = Ops::WIDTH;
+
+    const V v_dt = Ops::set1(dt);
+    const V v_zero = Ops::set1(0);
+    const V v_one = Ops::set1(1);
+    const V v_up = Ops::set1(UP);
+    const V v_down = Ops::set1(DOWN);
+    const V v_paddle_h = Ops::set1(PADDLE_HEIGHT);
+    const V v_paddle_limit = Ops::set1(GAME_HEIGHT-PADDLE_HEIGHT);
+    const V v_player_speed = Ops::set1(300);
+    const V v_ball_speed = Ops::set1(-400);
+    const V v_ball_size = Ops::set1(BALL_SIZE);
+    const V v_bottom_wall = Ops::set1(GAME_HEIGHT - BALL_SIZE);
+    const V v_player_face = Ops::set1(PADDLE_PLAYER_X + PADDLE_WIDTH);
+    const V v_player_x_min = Ops::set1(PADDLE_PLAYER_X - BALL_SIZE);
+    const V v_cpu_face = Ops::set1(PADDLE_CPU_X - BALL_SIZE);
+    const V v_cpu_x_max = Ops::set1(PADDLE_CPU_X + PADDLE_WIDTH);
+    const V v_stuck_low = Ops::set1(0.3f);
+    const V v_stuck_high = Ops::set1(0.7f);
+    const V v_goal_left = Ops::set1(-20);
+    const V v_goal_right = Ops::set1(GAME_WIDTH + 10);
+
+    for (int i = 0; i < batch->count; i += width) {
+        // Reset x component to prevent ball getting stuck in one dimension
+        V cx = Ops::load(batch->component_ball_x + i);
+        int stuck = Ops::movemask(Ops::or_mask(Ops::lt(cx, v_stuck_low), Ops::gt(cx, v_stuck_high)));
+        if (stuck) {
+            for (int lane = 0; lane < width && i + lane < batch->count; lane++) {
+                if (stuck & (1 << lane)) {
+                    batch->component_ball_x[i + lane] = SDL_randf_r(&batch->rng_state[i + lane]);
+                }
+            }
+            cx = Ops::load(batch->component_ball_x + i);
+        }
+
+        V py = Ops::load(batch->position_player_y + i);
+        V cy = Ops::load(batch->position_cpu_y + i);
+        V bx = Ops::load(batch->position_ball_x + i);
+        V by = Ops::load(batch->position_ball_y + i);
+        V dp = Ops::load(batch->direction_player + i);
+        V dc = Ops::load(batch->direction_cpu + i);
+        V dbx = Ops::load(batch->direction_ball_x + i);
+        V dby = Ops::load(batch->direction_ball_y + i);
+        V ball_mult = Ops::load(batch->ball_speed_multiplier + i);
+        V paddle_mult = Ops::load(batch->paddle_speed_multiplier + i);
+        V cpu_speed = Ops::load(batch->cpu_speed + i);
+
+        // Bound player to screen if exceeding window limit, else move player paddle
+        V player_moved = Ops::sub(py, Ops::mul(Ops::mul(Ops::mul(v_player_speed, dp), v_dt), paddle_mult));
+        py = Ops::select(Ops::lt(py, v_zero), v_zero,
+                Ops::select(Ops::gt(py, v_paddle_limit), v_paddle_limit, player_moved));
+
+        // Move CPU vertically in ping-pong motion
+        cy = Ops::sub(cy, Ops::mul(Ops::mul(Ops::mul(cpu_speed, dc), v_dt), paddle_mult));
+        dc = Ops::select(Ops::lt(cy, v_zero), v_down, dc);
+        dc = Ops::select(Ops::gt(cy, v_paddle_limit), v_up, dc);
+
+        V cy_component = Ops::sub(v_one, cx);
+
+        // Region each paddle blocks for the ball's top-left corner
+        const V player_y_min = Ops::sub(py, v_ball_size);
+        const V player_y_max = Ops::add(py, v_paddle_h);
+        const V cpu_y_min = Ops::sub(cy, v_ball_size);
+        const V cpu_y_max = Ops::add(cy, v_paddle_h);
+
+        // Swept bounces; a lane drops out of 'active' where match_step() breaks out of its loop
+        V time_left = v_one;
+        M active = Ops::true_mask();
+        I events = Ops::zero_int();
+        for (int bounce = 0; bounce < MATCH_MAX_BOUNCES && Ops::movemask(active); bounce++) {
+            const V velocity_x = Ops::mul(Ops::mul(Ops::mul(Ops::mul(v_ball_speed, dbx), cx), v_dt), ball_mult);
+            const V velocity_y = Ops::mul(Ops::mul(Ops::mul(Ops::mul(v_ball_speed, dby), cy_component), v_dt), ball_mult);
+            const M moving_up = Ops::lt(velocity_y, v_zero);
+            const M moving_down = Ops::gt(velocity_y, v_zero);
+
+            // Walls (sweep_wall)
+            const V t_top = Ops::max(Ops::div(Ops::sub(v_zero, by), velocity_y), v_zero);
+            const M hit_top = Ops::and_mask(moving_up, Ops::le(t_top, time_left));
+            const V t_bottom = Ops::max(Ops::div(Ops::sub(v_bottom_wall, by), velocity_y), v_zero);
+            const M hit_bottom = Ops::and_mask(moving_down, Ops::le(t_bottom, time_left));
+
+            // Paddle faces (sweep_x_face)
+            const V t_player_face = Ops::div(Ops::sub(v_player_face, bx), velocity_x);
+            const V y_player_face = Ops::add(by, Ops::mul(velocity_y, t_player_face));
+            const M hit_player_face = Ops::and_mask(Ops::and_mask(Ops::lt(velocity_x, v_zero),
+                    Ops::and_mask(Ops::ge(t_player_face, v_zero), Ops::le(t_player_face, time_left))),
+                    Ops::and_mask(Ops::ge(y_player_face, player_y_min), Ops::le(y_player_face, player_y_max)));
+
+            const V t_cpu_face = Ops::div(Ops::sub(v_cpu_face, bx), velocity_x);
+            const V y_cpu_face = Ops::add(by, Ops::mul(velocity_y, t_cpu_face));
+            const M hit_cpu_face = Ops::and_mask(Ops::and_mask(Ops::gt(velocity_x, v_zero),
+                    Ops::and_mask(Ops::ge(t_cpu_face, v_zero), Ops::le(t_cpu_face, time_left))),
+                    Ops::and_mask(Ops::ge(y_cpu_face, cpu_y_min), Ops::le(y_cpu_face, cpu_y_max)));
+
+            // Paddle top and bottom edges (sweep_y_face)
+            const V t_player_top = Ops::div(Ops::sub(player_y_min, by), velocity_y);
+            const V x_player_top = Ops::add(bx, Ops::mul(velocity_x, t_player_top));
+            const M hit_player_top = Ops::and_mask(Ops::and_mask(moving_down,
+                    Ops::and_mask(Ops::ge(t_player_top, v_zero), Ops::le(t_player_top, time_left))),
+                    Ops::and_mask(Ops::ge(x_player_top, v_player_x_min), Ops::le(x_player_top, v_player_face)));
+
+            const V t_player_bottom = Ops::div(Ops::sub(player_y_max, by), velocity_y);
+            const V x_player_bottom = Ops::add(bx, Ops::mul(velocity_x, t_player_bottom));
+            const M hit_player_bottom = Ops::and_mask(Ops::and_mask(moving_up,
+                    Ops::and_mask(Ops::ge(t_player_bottom, v_zero), Ops::le(t_player_bottom, time_left))),
+                    Ops::and_mask(Ops::ge(x_player_bottom, v_player_x_min), Ops::le(x_player_bottom, v_player_face)));
+
+            const V t_cpu_top = Ops::div(Ops::sub(cpu_y_min, by), velocity_y);
+            const V x_cpu_top = Ops::add(bx, Ops::mul(velocity_x, t_cpu_top));
+            const M hit_cpu_top = Ops::and_mask(Ops::and_mask(moving_down,
+                    Ops::and_mask(Ops::ge(t_cpu_top, v_zero), Ops::le(t_cpu_top, time_left))),
+                    Ops::and_mask(Ops::ge(x_cpu_top, v_cpu_face), Ops::le(x_cpu_top, v_cpu_x_max)));
+
+            const V t_cpu_bottom = Ops::div(Ops::sub(cpu_y_max, by), velocity_y);
+            const V x_cpu_bottom = Ops::add(bx, Ops::mul(velocity_x, t_cpu_bottom));
+            const M hit_cpu_bottom = Ops::and_mask(Ops::and_mask(moving_up,
+                    Ops::and_mask(Ops::ge(t_cpu_bottom, v_zero), Ops::le(t_cpu_bottom, time_left))),
+                    Ops::and_mask(Ops::ge(x_cpu_bottom, v_cpu_face), Ops::le(x_cpu_bottom, v_cpu_x_max)));
+
+            // Earliest contact
+            V t = time_left;
+            t = Ops::select(Ops::and_mask(hit_top, Ops::lt(t_top, t)), t_top, t);
+            t = Ops::select(Ops::and_mask(hit_bottom, Ops::lt(t_bottom, t)), t_bottom, t);
+            t = Ops::select(Ops::and_mask(hit_player_face, Ops::lt(t_player_face, t)), t_player_face, t);
+            t = Ops::select(Ops::and_mask(hit_player_top, Ops::lt(t_player_top, t)), t_player_top, t);
+            t = Ops::select(Ops::and_mask(hit_player_bottom, Ops::lt(t_player_bottom, t)), t_player_bottom, t);
+            t = Ops::select(Ops::and_mask(hit_cpu_face, Ops::lt(t_cpu_face, t)), t_cpu_face, t);
+            t = Ops::select(Ops::and_mask(hit_cpu_top, Ops::lt(t_cpu_top, t)), t_cpu_top, t);
+            t = Ops::select(Ops::and_mask(hit_cpu_bottom, Ops::lt(t_cpu_bottom, t)), t_cpu_bottom, t);
+
+            bx = Ops::select(active, Ops::add(bx, Ops::mul(velocity_x, t)), bx);
+            by = Ops::select(active, Ops::add(by, Ops::mul(velocity_y, t)), by);
+            time_left = Ops::select(active, Ops::sub(time_left, t), time_left);
+
+            const M player_face = Ops::and_mask(active, Ops::and_mask(hit_player_face, Ops::eq(t_player_face, t)));
+            const M cpu_face = Ops::and_mask(active, Ops::and_mask(hit_cpu_face, Ops::eq(t_cpu_face, t)));
+            const M player_edge = Ops::and_mask(active, Ops::or_mask(Ops::and_mask(hit_player_top, Ops::eq(t_player_top, t)),
+                    Ops::and_mask(hit_player_bottom, Ops::eq(t_player_bottom, t))));
+            const M cpu_edge = Ops::and_mask(active, Ops::or_mask(Ops::and_mask(hit_cpu_top, Ops::eq(t_cpu_top, t)),
+                    Ops::and_mask(hit_cpu_bottom, Ops::eq(t_cpu_bottom, t))));
+            const M wall = Ops::and_mask(active, Ops::or_mask(Ops::and_mask(hit_top, Ops::eq(t_top, t)),
+                    Ops::and_mask(hit_bottom, Ops::eq(t_bottom, t))));
+
+            const M reflect_x = Ops::or_mask(player_face, cpu_face);
+            const M reflect_y = Ops::or_mask(Ops::or_mask(player_edge, cpu_edge), wall);
+            active = Ops::or_mask(reflect_x, reflect_y);
+
+            events = Ops::ior(events, Ops::bits(Ops::or_mask(player_face, player_edge), MATCH_EVENT_HIT_PLAYER));
+            events = Ops::ior(events, Ops::bits(Ops::or_mask(cpu_face, cpu_edge), MATCH_EVENT_HIT_CPU));
+
+            dbx = Ops::select(reflect_x, Ops::sub(v_zero, dbx), dbx);
+            // Reflection wins, else change direction of ball to direction of paddle
+            V steered = Ops::select(Ops::and_mask(cpu_face, Ops::ne(dc, v_zero)), dc, dby);
+            steered = Ops::select(Ops::and_mask(player_face, Ops::ne(dp, v_zero)), dp, steered);
+            dby = Ops::select(reflect_y, Ops::sub(v_zero, dby), steered);
+        }
+
+        Ops::store(batch->position_player_y + i, py);
+        Ops::store(batch->position_cpu_y + i, cy);
+        Ops::store(batch->position_ball_x + i, bx);
+        Ops::store(batch->position_ball_y + i, by);
+        Ops::store(batch->direction_cpu + i, dc);
+        Ops::store(batch->direction_ball_x + i, dbx);
+        Ops::store(batch->direction_ball_y + i, dby);
+        Ops::store_int(batch->events + i, events);
+
+        // When ball crosses left or right side of screen and someone scores
+        int scored = Ops::movemask(Ops::or_mask(Ops::lt(bx, v_goal_left), Ops::gt(bx, v_goal_right)));
+        if (scored) {
+            for (int lane = 0; lane < width && i + lane < batch->count; lane++) {
+                if (scored & (1 << lane)) {
+                    serve_lane(batch, i + lane);
+                }
+            }
+        }
+    }
+}
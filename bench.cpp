@@ -0,0 +1,459 @@
+/* pong_bench: microbenchmarks for the hot paths of a frame, runnable on a machine
+ * without a GPU, display or sound card.
+ *
+ * Usage: pong_bench [--filter TEXT] [--min-time SECONDS] [--repetitions N]
+ *
+ * Each benchmark is calibrated to run for at least --min-time, then timed
+ * --repetitions times. One JSON object per benchmark is printed to stdout:
+ *   {"name": "match_step", "ops": 1048576, "ns_per_op_min": 11.2, "ns_per_op_median": 11.4}
+ */
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+#include <stdio.h>
+#include "match.h"
+#include "batch.h"
+#include "scenes.h"
+#include "music.h"
+#include "mixer.h"
+#include "swarm.h"
+#include "particles.h"
+#include "pong_env.h"
+
+typedef struct BenchOptions {
+    const char *filter;     // Only run benchmarks whose name contains this
+    double min_time;
+    int repetitions;
+} BenchOptions;
+
+// Run the operation 'iterations' times, returning how many ops that was
+typedef Uint64 (*BenchFunction)(void *state, Uint64 iterations);
+
+static const int MAX_REPETITIONS = 64;
+
+static int compare_doubles(const void *a, const void *b) {
+    const double x = *(const double *) a;
+    const double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static void run_benchmark(const BenchOptions *options, const char *name, BenchFunction function, void *state) {
+    if (options->filter != NULL && SDL_strstr(name, options->filter) == NULL) {
+        return;
+    }
+
+    // Grow the iteration count until one run takes long enough to time reliably
+    Uint64 iterations = 1;
+    for (;;) {
+        const Uint64 start = SDL_GetTicksNS();
+        function(state, iterations);
+        const double seconds = (double) (SDL_GetTicksNS() - start) / SDL_NS_PER_SECOND;
+        if (seconds >= options->min_time || iterations >= (1ull << 40)) {
+            break;
+        }
+        iterations *= (seconds < options->min_time / 10) ? 10 : 2;
+    }
+
+    double ns_per_op[MAX_REPETITIONS];
+    Uint64 ops = 0;
+    for (int i = 0; i < options->repetitions; i++) {
+        const Uint64 start = SDL_GetTicksNS();
+        ops = function(state, iterations);
+        ns_per_op[i] = (double) (SDL_GetTicksNS() - start) / ops;
+    }
+    SDL_qsort(ns_per_op, options->repetitions, sizeof(double), compare_doubles);
+
+    printf("{\"name\": \"%s\", \"ops\": %" SDL_PRIu64 ", \"ns_per_op_min\": %.3f, \"ns_per_op_median\": %.3f}\n",
+           name, ops, ns_per_op[0], ns_per_op[options->repetitions / 2]);
+    fflush(stdout);
+}
+
+// Ball and paddle update of one match, player on autoplay
+static Uint64 bench_match_step(void *state, Uint64 iterations) {
+    Match *match = (Match *) state;
+    for (Uint64 i = 0; i < iterations; i++) {
+        match->direction_player = match_autoplay_direction(match);
+        match_step(match, SIM_DT);
+    }
+    return iterations;
+}
+
+typedef struct BatchBench {
+    MatchBatch batch;
+    BatchIsa isa;
+} BatchBench;
+
+// Same update for a whole batch; one op is one match stepped once
+static Uint64 bench_batch_step(void *state, Uint64 iterations) {
+    BatchBench *bench = (BatchBench *) state;
+    for (Uint64 i = 0; i < iterations; i++) {
+        batch_autoplay(&bench->batch);
+        batch_step(&bench->batch, SIM_DT, bench->isa);
+    }
+    return iterations * bench->batch.count;
+}
+
+typedef struct SwarmBench {
+    BallSwarm swarm;
+    Match match;
+    SDL_Renderer *renderer;
+} SwarmBench;
+
+// Stress mode's swarm moving alongside a match; one op is one ball stepped once
+static Uint64 bench_swarm_step(void *state, Uint64 iterations) {
+    SwarmBench *bench = (SwarmBench *) state;
+    for (Uint64 i = 0; i < iterations; i++) {
+        bench->match.direction_player = match_autoplay_direction(&bench->match);
+        match_step(&bench->match, SIM_DT);
+        swarm_step(&bench->swarm, &bench->match, SIM_DT);
+    }
+    return iterations * bench->swarm.count;
+}
+
+// Submit and draw every ball of the swarm; one op is one ball
+static Uint64 bench_render_swarm(void *state, Uint64 iterations) {
+    SwarmBench *bench = (SwarmBench *) state;
+    for (Uint64 i = 0; i < iterations; i++) {
+        swarm_draw(&bench->swarm, bench->renderer);
+    }
+    SDL_FlushRenderer(bench->renderer);
+    return iterations * bench->swarm.count;
+}
+
+typedef struct EnvBench {
+    PongEnv *env;
+    int32_t *actions;
+    float *observations;
+    float *rewards;
+    uint8_t *dones;
+} EnvBench;
+
+// The training environment stepped on every core; one op is one env stepped once (4 ticks)
+static Uint64 bench_env_step(void *state, Uint64 iterations) {
+    EnvBench *bench = (EnvBench *) state;
+    const int count = pong_env_num_envs(bench->env);
+    for (Uint64 i = 0; i < iterations; i++) {
+        for (int n = 0; n < count; n++) {
+            bench->actions[n] = (int32_t) ((i + n) % 3);
+        }
+        pong_env_step(bench->env, bench->actions, bench->observations, bench->rewards, bench->dones);
+    }
+    return iterations * count;
+}
+
+// A full particle pool aged a tick and topped up again; one op is one particle updated
+static Uint64 bench_particles_update(void *state, Uint64 iterations) {
+    ParticleSystem *particles = (ParticleSystem *) state;
+    const ParticleEmitter burst = {256, 0, SDL_PI_F, 60, 420, 0.4f, 1.1f, 4, {1, 1, 1, 1}};
+    Uint64 ops = 0;
+    for (Uint64 i = 0; i < iterations; i++) {
+        while (particles->count + burst.count <= particles->capacity) {
+            particles_emit(particles, &burst, GAME_WIDTH/2, GAME_HEIGHT/2);
+        }
+        ops += particles->count;
+        particles_update(particles, SIM_DT);
+    }
+    return ops;
+}
+
+typedef struct RenderBench {
+    SDL_Renderer *renderer;
+    Match match;
+    ConfigView config;
+} RenderBench;
+
+// Submit a full GAME frame and have the software renderer draw it
+static Uint64 bench_render_game(void *state, Uint64 iterations) {
+    RenderBench *bench = (RenderBench *) state;
+    for (Uint64 i = 0; i < iterations; i++) {
+        match_step(&bench->match, SIM_DT);
+
+        GameView view;
+        view.position_player_y = bench->match.position_player_y;
+        view.position_cpu_y = bench->match.position_cpu_y;
+        view.position_ball_x = bench->match.position_ball_x;
+        view.position_ball_y = bench->match.position_ball_y;
+        view.score_player = bench->match.score_player;
+        view.score_cpu = bench->match.score_cpu;
+        scene_render_game(bench->renderer, &view);
+        SDL_FlushRenderer(bench->renderer);
+    }
+    return iterations;
+}
+
+// The options menu, the screen with the most text, with the selection moving every frame
+static Uint64 bench_render_config(void *state, Uint64 iterations) {
+    RenderBench *bench = (RenderBench *) state;
+    for (Uint64 i = 0; i < iterations; i++) {
+        bench->config.options_choice = static_cast<Option>(i % (BACK+1));
+        scene_render_config(bench->renderer, &bench->config);
+        SDL_FlushRenderer(bench->renderer);
+    }
+    return iterations;
+}
+
+// Options menu left alone, as on most menu frames
+static Uint64 bench_render_config_idle(void *state, Uint64 iterations) {
+    RenderBench *bench = (RenderBench *) state;
+    bench->config.options_choice = RESOLUTION;
+    for (Uint64 i = 0; i < iterations; i++) {
+        scene_render_config(bench->renderer, &bench->config);
+        SDL_FlushRenderer(bench->renderer);
+    }
+    return iterations;
+}
+
+typedef struct MusicBench {
+    MusicStream music;
+    Uint8 *drain;
+    int drain_len;      // What a device takes from the stream in one 60 Hz frame
+} MusicBench;
+
+// One frame of looping music: top the ring up as the game does, then let the "device" pull
+static Uint64 bench_music_stream(void *state, Uint64 iterations) {
+    MusicBench *bench = (MusicBench *) state;
+    for (Uint64 i = 0; i < iterations; i++) {
+        music_update(&bench->music);
+        SDL_GetAudioStreamData(bench->music.stream, bench->drain, bench->drain_len);
+    }
+    return iterations;
+}
+
+typedef struct MixerBench {
+    Mixer mixer;
+    Uint8 *drain;
+    int drain_len;
+} MixerBench;
+
+// One frame of effects: a new one every few frames so several voices overlap
+static Uint64 bench_mixer(void *state, Uint64 iterations) {
+    MixerBench *bench = (MixerBench *) state;
+    for (Uint64 i = 0; i < iterations; i++) {
+        if (i % 4 == 0) {
+            mixer_play(&bench->mixer, 0);
+        }
+        SDL_GetAudioStreamData(bench->mixer.stream, bench->drain, bench->drain_len);
+    }
+    return iterations;
+}
+
+// A silent 16-bit PCM .wav of 'frames' frames in memory, for the audio benchmarks
+static SDL_IOStream *create_test_wav(const SDL_AudioSpec *spec, Uint32 frames, Uint8 **buffer) {
+    const Uint32 data_len = frames * SDL_AUDIO_FRAMESIZE(*spec);
+    const Uint32 wav_len = 44 + data_len;
+    *buffer = (Uint8 *) SDL_calloc(1, wav_len);
+    SDL_IOStream *io = *buffer ? SDL_IOFromMem(*buffer, wav_len) : NULL;
+    if (!io) {
+        SDL_Log("Couldn't build test WAV: %s", SDL_GetError());
+        return NULL;
+    }
+    SDL_WriteIO(io, "RIFF", 4);
+    SDL_WriteU32LE(io, wav_len - 8);
+    SDL_WriteIO(io, "WAVEfmt ", 8);
+    SDL_WriteU32LE(io, 16);
+    SDL_WriteU16LE(io, 1);
+    SDL_WriteU16LE(io, spec->channels);
+    SDL_WriteU32LE(io, spec->freq);
+    SDL_WriteU32LE(io, spec->freq * SDL_AUDIO_FRAMESIZE(*spec));
+    SDL_WriteU16LE(io, SDL_AUDIO_FRAMESIZE(*spec));
+    SDL_WriteU16LE(io, SDL_AUDIO_BITSIZE(spec->format));
+    SDL_WriteIO(io, "data", 4);
+    SDL_WriteU32LE(io, data_len);
+    SDL_SeekIO(io, 0, SDL_IO_SEEK_SET);
+    return io;
+}
+
+static bool parse_options(int argc, char *argv[], BenchOptions *options) {
+    options->filter = NULL;
+    options->min_time = 0.2;
+    options->repetitions = 5;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (value == NULL) {
+            SDL_Log("Missing value for '%s'", arg);
+            return false;
+        }
+
+        if (SDL_strcmp(arg, "--filter") == 0) {
+            options->filter = value;
+        } else if (SDL_strcmp(arg, "--min-time") == 0) {
+            options->min_time = SDL_atof(value);
+        } else if (SDL_strcmp(arg, "--repetitions") == 0) {
+            options->repetitions = SDL_atoi(value);
+        } else {
+            SDL_Log("Unknown option '%s'", arg);
+            return false;
+        }
+        i++;
+    }
+
+    if (options->min_time <= 0 || options->repetitions <= 0 || options->repetitions > MAX_REPETITIONS) {
+        SDL_Log("--min-time must be positive and --repetitions between 1 and %d", MAX_REPETITIONS);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options;
+    if (!parse_options(argc, argv, &options)) {
+        return 1;
+    }
+
+    MatchConfig config;
+    match_default_config(&config);
+
+    Match match;
+    match_init(&match, &config, 1);
+    run_benchmark(&options, "match_step", bench_match_step, &match);
+
+    // Same with the predicting CPU re-aiming every tick, its most expensive setting
+    MatchConfig predict_config = config;
+    match_set_cpu_level(&predict_config, MATCH_CPU_LEVELS - 1);
+    predict_config.cpu_reaction = 0;
+    match_init(&match, &predict_config, 1);
+    run_benchmark(&options, "match_step_cpu_predict", bench_match_step, &match);
+
+    BatchBench batch_bench;
+    if (!batch_create(&batch_bench.batch, 1024)) {
+        SDL_Log("Couldn't allocate batch");
+        return 1;
+    }
+    for (int i = 0; i < batch_bench.batch.count; i++) {
+        match_init(&match, &config, match_seed(1, i));
+        batch_set_match(&batch_bench.batch, i, &match);
+    }
+    const BatchIsa isas[] = {BATCH_ISA_SCALAR, BATCH_ISA_SSE2, BATCH_ISA_AVX2};
+    for (size_t n = 0; n < SDL_arraysize(isas); n++) {
+        if (batch_isa_supported(isas[n])) {
+            char name[64];
+            SDL_snprintf(name, sizeof(name), "batch_step_%s", batch_isa_name(isas[n]));
+            batch_bench.isa = isas[n];
+            run_benchmark(&options, name, bench_batch_step, &batch_bench);
+        }
+    }
+    batch_destroy(&batch_bench.batch);
+
+    PongEnvConfig env_config;
+    pong_env_default_config(&env_config);
+    env_config.num_envs = 16384;
+    EnvBench env_bench;
+    env_bench.env = pong_env_create(&env_config);
+    env_bench.actions = (int32_t *) SDL_malloc(env_config.num_envs * sizeof(int32_t));
+    env_bench.observations = (float *) SDL_malloc(env_config.num_envs * PONG_ENV_OBS_SIZE * sizeof(float));
+    env_bench.rewards = (float *) SDL_malloc(env_config.num_envs * sizeof(float));
+    env_bench.dones = (uint8_t *) SDL_malloc(env_config.num_envs);
+    if (!env_bench.env || !env_bench.actions || !env_bench.observations || !env_bench.rewards || !env_bench.dones) {
+        SDL_Log("Couldn't create training environment");
+        return 1;
+    }
+    pong_env_reset(env_bench.env, env_bench.observations);
+    run_benchmark(&options, "env_step_16384", bench_env_step, &env_bench);
+    pong_env_destroy(env_bench.env);
+    SDL_free(env_bench.actions);
+    SDL_free(env_bench.observations);
+    SDL_free(env_bench.rewards);
+    SDL_free(env_bench.dones);
+
+    // Swarms settled for a second first, so the balls have spread out as they would in play
+    SwarmBench swarm_bench;
+    const int swarm_sizes[] = {1024, 4096, 16384};
+    for (size_t n = 0; n < SDL_arraysize(swarm_sizes); n++) {
+        if (!swarm_create(&swarm_bench.swarm, swarm_sizes[n], 1)) {
+            SDL_Log("Couldn't allocate swarm");
+            return 1;
+        }
+        swarm_spawn(&swarm_bench.swarm, swarm_sizes[n]);
+        match_init(&swarm_bench.match, &config, 1);
+        bench_swarm_step(&swarm_bench, SIM_TICK_RATE);
+
+        char name[64];
+        SDL_snprintf(name, sizeof(name), "swarm_step_%d", swarm_sizes[n]);
+        run_benchmark(&options, name, bench_swarm_step, &swarm_bench);
+        if (n + 1 < SDL_arraysize(swarm_sizes)) {
+            swarm_destroy(&swarm_bench.swarm);
+        }
+    }
+
+    ParticleSystem particles;
+    if (!particles_create(&particles, 2048, 1)) {
+        SDL_Log("Couldn't allocate particles");
+        return 1;
+    }
+    run_benchmark(&options, "particles_update_2048", bench_particles_update, &particles);
+    particles_destroy(&particles);
+
+    // Software renderer drawing into an offscreen target texture
+    SDL_Surface *surface = SDL_CreateSurface(GAME_WIDTH, GAME_HEIGHT, SDL_PIXELFORMAT_XRGB8888);
+    RenderBench render_bench;
+    render_bench.renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    if (!render_bench.renderer) {
+        SDL_Log("Couldn't create software renderer: %s", SDL_GetError());
+        return 1;
+    }
+    SDL_Texture *target = SDL_CreateTexture(render_bench.renderer, SDL_PIXELFORMAT_XRGB8888,
+                                            SDL_TEXTUREACCESS_TARGET, GAME_WIDTH, GAME_HEIGHT);
+    if (!target || !SDL_SetRenderTarget(render_bench.renderer, target)) {
+        SDL_Log("Couldn't create render target: %s", SDL_GetError());
+        return 1;
+    }
+    if (!scene_init()) {
+        return 1;
+    }
+    match_init(&render_bench.match, &config, 1);
+    render_bench.config = {RESOLUTION, VGA, true, F_VSYNC, true, B_MEDIUM, P_MEDIUM, C_MEDIUM};
+    run_benchmark(&options, "render_game", bench_render_game, &render_bench);
+    run_benchmark(&options, "render_config", bench_render_config, &render_bench);
+    run_benchmark(&options, "render_config_idle", bench_render_config_idle, &render_bench);
+    swarm_bench.renderer = render_bench.renderer;
+    run_benchmark(&options, "render_swarm_16384", bench_render_swarm, &swarm_bench);
+    swarm_destroy(&swarm_bench.swarm);
+    scene_quit();
+    SDL_DestroyTexture(target);
+    SDL_DestroyRenderer(render_bench.renderer);
+    SDL_DestroySurface(surface);
+
+    /* Looping music as the game streams it: a one second 44.1 kHz 16-bit stereo WAV read
+       from memory through the default ring, converted to the 48 kHz float most devices ask
+       for. No device is opened; the benchmark pulls one frame's worth of audio itself. */
+    const SDL_AudioSpec wav_spec = {SDL_AUDIO_S16, 2, 44100};
+    const SDL_AudioSpec device_spec = {SDL_AUDIO_F32, 2, 48000};
+    Uint8 *wav = NULL;
+    SDL_IOStream *wav_io = create_test_wav(&wav_spec, wav_spec.freq, &wav);
+    if (!wav_io) {
+        return 1;
+    }
+
+    MusicBench music_bench;
+    music_bench.drain_len = device_spec.freq / 60 * SDL_AUDIO_FRAMESIZE(device_spec);
+    music_bench.drain = (Uint8 *) SDL_malloc(music_bench.drain_len);
+    if (!music_bench.drain || !music_open_io(&music_bench.music, wav_io, 0, MUSIC_DEFAULT_BUFFER_MS) ||
+        !SDL_SetAudioStreamFormat(music_bench.music.stream, NULL, &device_spec)) {
+        SDL_Log("Couldn't set up music stream: %s", SDL_GetError());
+        return 1;
+    }
+    run_benchmark(&options, "music_stream", bench_music_stream, &music_bench);
+    music_close(&music_bench.music);
+    SDL_free(music_bench.drain);
+    SDL_free(wav);
+
+    // Sound effects: a quarter second effect retriggered every fourth frame, mixed at 48 kHz
+    MixerBench mixer_bench;
+    mixer_bench.drain_len = music_bench.drain_len;
+    mixer_bench.drain = (Uint8 *) SDL_malloc(mixer_bench.drain_len);
+    wav_io = create_test_wav(&wav_spec, wav_spec.freq / 4, &wav);
+    if (!mixer_bench.drain || !wav_io || !mixer_open(&mixer_bench.mixer, 0) ||
+        !mixer_load_io(&mixer_bench.mixer, 0, wav_io)) {
+        SDL_Log("Couldn't set up mixer: %s", SDL_GetError());
+        return 1;
+    }
+    run_benchmark(&options, "mixer", bench_mixer, &mixer_bench);
+    mixer_close(&mixer_bench.mixer);
+    SDL_free(mixer_bench.drain);
+    SDL_free(wav);
+
+    SDL_Quit();
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "bundle.h"
+#include "adpcm.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Map the whole file read-only; NULL if the platform or file doesn't allow it
+static const Uint8 *map_file(const char *path, size_t *size) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    LARGE_INTEGER file_size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    CloseHandle(file);
+    if (!mapping) {
+        return NULL;
+    }
+    const Uint8 *data = (const Uint8 *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);   // The view keeps the mapping alive
+    *size = (size_t) file_size.QuadPart;
+    return data;
+#else
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    *size = (size_t) info.st_size;
+    return (const Uint8 *) data;
+#endif
+}
+
+static void unmap_file(const Uint8 *data, size_t size) {
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+#else
+    munmap((void *) data, size);
+#endif
+}
+
+static Uint16 read_u16(const Uint8 *p) {
+    return (Uint16) (p[0] | (p[1] << 8));
+}
+
+static Uint32 read_u32(const Uint8 *p) {
+    return (Uint32) p[0] | ((Uint32) p[1] << 8) | ((Uint32) p[2] << 16) | ((Uint32) p[3] << 24);
+}
+
+static Uint64 read_u64(const Uint8 *p) {
+    return (Uint64) read_u32(p) | ((Uint64) read_u32(p + 4) << 32);
+}
+
+// Bytes an entry's samples must take, so readers can trust 'frames'
+static Uint64 expected_size(const AssetBundle *bundle, const BundleEntry *entry) {
+    if (entry->codec == BUNDLE_CODEC_ADPCM) {
+        const Uint64 blocks = ((Uint64) entry->frames + ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES;
+        return blocks * adpcm_block_size(bundle->spec.channels);
+    }
+    return (Uint64) entry->frames * SDL_AUDIO_FRAMESIZE(bundle->spec);
+}
+
+static bool parse_index(AssetBundle *bundle) {
+    const Uint8 *p = bundle->data;
+    if (bundle->size < (size_t) BUNDLE_HEADER_SIZE || SDL_memcmp(p, "PONGBNDL", 8) != 0) {
+        return SDL_SetError("Not an asset bundle");
+    }
+    if (read_u32(p + 8) != BUNDLE_VERSION) {
+        return SDL_SetError("Asset bundle version %u, expected %u", read_u32(p + 8), BUNDLE_VERSION);
+    }
+    bundle->count = (int) read_u32(p + 12);
+    bundle->spec.format = SDL_AUDIO_S16;
+    bundle->spec.freq = (int) read_u32(p + 16);
+    bundle->spec.channels = read_u16(p + 20);
+    if (bundle->count < 0 || bundle->spec.freq <= 0 || bundle->spec.channels <= 0 ||
+        (size_t) BUNDLE_HEADER_SIZE + (size_t) bundle->count * BUNDLE_ENTRY_SIZE > bundle->size) {
+        return SDL_SetError("Corrupt asset bundle header");
+    }
+
+    bundle->entries = (BundleEntry *) SDL_calloc(SDL_max(bundle->count, 1), sizeof(BundleEntry));
+    if (!bundle->entries) {
+        return false;
+    }
+    for (int i = 0; i < bundle->count; i++) {
+        const Uint8 *e = p + BUNDLE_HEADER_SIZE + i * BUNDLE_ENTRY_SIZE;
+        BundleEntry *entry = &bundle->entries[i];
+        SDL_memcpy(entry->name, e, BUNDLE_NAME_SIZE);
+        entry->name[BUNDLE_NAME_SIZE - 1] = '\0';
+        entry->codec = read_u32(e + 32);
+        entry->frames = read_u32(e + 36);
+        entry->offset = read_u64(e + 40);
+        entry->size = read_u64(e + 48);
+        if (entry->offset > bundle->size || entry->size > bundle->size - entry->offset) {
+            return SDL_SetError("Asset bundle entry '%s' runs past the end of the file", entry->name);
+        }
+        if (entry->codec > BUNDLE_CODEC_ADPCM || entry->size < expected_size(bundle, entry)) {
+            return SDL_SetError("Asset bundle entry '%s' is corrupt", entry->name);
+        }
+    }
+    return true;
+}
+
+bool bundle_open(AssetBundle *bundle, const char *path) {
+    SDL_zerop(bundle);
+    bundle->data = map_file(path, &bundle->size);
+    bundle->mapped = (bundle->data != NULL);
+    if (!bundle->mapped) {
+        bundle->data = (const Uint8 *) SDL_LoadFile(path, &bundle->size);
+        if (!bundle->data) {
+            return false;
+        }
+    }
+
+    if (!parse_index(bundle)) {
+        bundle_close(bundle);
+        return false;
+    }
+    return true;
+}
+
+const BundleEntry *bundle_find(const AssetBundle *bundle, const char *name) {
+    for (int i = 0; i < bundle->count; i++) {
+        if (SDL_strcmp(bundle->entries[i].name, name) == 0) {
+            return &bundle->entries[i];
+        }
+    }
+    return NULL;
+}
+
+const Uint8 *bundle_entry_data(const AssetBundle *bundle, const BundleEntry *entry) {
+    return bundle->data + entry->offset;
+}
+
+void bundle_close(AssetBundle *bundle) {
+    if (bundle->data) {
+        if (bundle->mapped) {
+            unmap_file(bundle->data, bundle->size);
+        } else {
+            SDL_free((void *) bundle->data);
+        }
+    }
+    SDL_free(bundle->entries);
+    SDL_zerop(bundle);
+}
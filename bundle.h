@@ -0,0 +1,53 @@
+/* Asset bundle: every sound of the game in one file, already converted to the format the
+ * mixer and music play, memory-mapped at startup instead of each .wav being loaded and
+ * converted. Built from the .wav files by pong_pack.
+ *
+ * Layout, little-endian:
+ *   header   "PONGBNDL", U32 version, U32 entry count, U32 rate, U16 channels, U16 0
+ *   entries  char name[32], U32 codec, U32 frames, U64 offset, U64 size
+ *   data     samples of each entry, 16-byte aligned
+ */
+
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include <SDL3/SDL.h>
+
+const Uint32 BUNDLE_VERSION = 1;
+const int BUNDLE_HEADER_SIZE = 24;
+const int BUNDLE_ENTRY_SIZE = 56;
+const int BUNDLE_NAME_SIZE = 32;
+
+enum BundleCodec {
+    BUNDLE_CODEC_S16 = 0,       // Interleaved signed 16-bit PCM
+    BUNDLE_CODEC_ADPCM = 1      // IMA ADPCM blocks, see adpcm.h
+};
+
+typedef struct BundleEntry {
+    char name[BUNDLE_NAME_SIZE];    // File name of the source .wav
+    Uint32 codec;
+    Uint32 frames;
+    Uint64 offset;
+    Uint64 size;
+} BundleEntry;
+
+typedef struct AssetBundle {
+    const Uint8 *data;
+    size_t size;
+    bool mapped;                // Otherwise 'data' was read into memory
+    SDL_AudioSpec spec;         // S16 at the bundle's rate and channel count
+    BundleEntry *entries;
+    int count;
+} AssetBundle;
+
+// Map the bundle at 'path'; false (with an SDL error set) if it is missing or invalid
+bool bundle_open(AssetBundle *bundle, const char *path);
+
+// Entry called 'name', or NULL
+const BundleEntry *bundle_find(const AssetBundle *bundle, const char *name);
+
+const Uint8 *bundle_entry_data(const AssetBundle *bundle, const BundleEntry *entry);
+
+void bundle_close(AssetBundle *bundle);
+
+#endif
@@ -0,0 +1,406 @@
+#include "capture.h"
+#include "match.h"
+#include "replay.h"
+#include "scenes.h"
+#include <atomic>
+
+/* Usage:
+ *   pong --export FILE [--replay FILE | --seed S] [--seconds N] [--size WxH] [--fps N]
+ *                      [--format y4m|rgb]
+ *
+ * Renders the GAME scene of --replay, or of an autoplayed match started from --seed, at
+ * --fps (default 60) and --size (default GAME_WIDTHxGAME_HEIGHT; the court is letterboxed
+ * into other shapes). --seconds stops early; an autoplayed match runs 30 s without it.
+ * FILE may be a pipe, eg /dev/stdout:
+ *
+ *   pong --export /dev/stdout --replay match.rpl --size 1280x960 | ffmpeg -i - match.mp4
+ *
+ * y4m (the default unless FILE ends in .rgb) is YUV4MPEG2 with 4:2:0 BT.601 limited
+ * range frames and needs an even width and height; rgb is bare RGB24 frames, eg for
+ * 'ffmpeg -f rawvideo -pixel_format rgb24 -video_size WxH -framerate N -i FILE'.
+ *
+ * The main thread simulates and renders each frame into a software surface, then copies
+ * it into a free slot of a small ring. A writer thread converts the slots, in order, to
+ * the output format and writes them, so rendering one frame overlaps writing another.
+ * The ring is bounded: a renderer that gets ahead waits for the writer, and the other
+ * way round, which is what the report's "waiting" times show.
+ */
+
+// Frames in flight between the renderer and the writer
+static const int CAPTURE_QUEUE_FRAMES = 8;
+
+enum CaptureFormat {
+    CAPTURE_Y4M,
+    CAPTURE_RGB
+};
+
+typedef struct CaptureOptions {
+    const char *path;
+    const char *replay_path;
+    Uint64 seed;
+    float seconds;
+    int width;
+    int height;
+    int fps;
+    CaptureFormat format;
+} CaptureOptions;
+
+/* The renderer fills slots in ring order and the writer empties them in the same order.
+   The semaphores count the free and the filled slots, so each side only ever touches a
+   slot the other has handed over. The last slot filled is marked as the end. */
+typedef struct CaptureQueue {
+    int width;
+    int height;
+    CaptureFormat format;
+    SDL_IOStream *io;
+    Uint8 *frames[CAPTURE_QUEUE_FRAMES];    // XRGB8888, 'width * 4' bytes a row
+    bool end[CAPTURE_QUEUE_FRAMES];
+    SDL_Semaphore *free_slots;
+    SDL_Semaphore *full_slots;
+    Uint8 *converted;                       // One frame in the output format
+    size_t converted_size;
+
+    // Written by the writer thread
+    std::atomic<bool> failed;
+    Uint64 frames_written;
+    Uint64 convert_ns;
+    Uint64 write_ns;
+    Uint64 wait_ns;                         // For the renderer to fill a slot
+} CaptureQueue;
+
+bool capture_requested(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (SDL_strcmp(argv[i], "--export") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_options(int argc, char *argv[], CaptureOptions *options) {
+    options->path = NULL;
+    options->replay_path = NULL;
+    options->seed = 1;
+    options->seconds = 0;
+    options->width = GAME_WIDTH;
+    options->height = GAME_HEIGHT;
+    options->fps = 60;
+    options->format = CAPTURE_Y4M;
+    const char *format = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (value == NULL) {
+            SDL_Log("Missing value for '%s'", arg);
+            return false;
+        }
+
+        if (SDL_strcmp(arg, "--export") == 0) {
+            options->path = value;
+        } else if (SDL_strcmp(arg, "--replay") == 0) {
+            options->replay_path = value;
+        } else if (SDL_strcmp(arg, "--seed") == 0) {
+            options->seed = SDL_strtoull(value, NULL, 10);
+        } else if (SDL_strcmp(arg, "--seconds") == 0) {
+            options->seconds = (float) SDL_atof(value);
+        } else if (SDL_strcmp(arg, "--size") == 0) {
+            if (SDL_sscanf(value, "%dx%d", &options->width, &options->height) != 2) {
+                SDL_Log("--size must look like 1280x960");
+                return false;
+            }
+        } else if (SDL_strcmp(arg, "--fps") == 0) {
+            options->fps = SDL_atoi(value);
+        } else if (SDL_strcmp(arg, "--format") == 0) {
+            format = value;
+        } else {
+            SDL_Log("Unknown export option '%s'", arg);
+            return false;
+        }
+        i++;
+    }
+
+    if (format == NULL) {
+        const size_t length = SDL_strlen(options->path);
+        const bool rgb = length >= 4 && SDL_strcasecmp(options->path + length - 4, ".rgb") == 0;
+        options->format = rgb ? CAPTURE_RGB : CAPTURE_Y4M;
+    } else if (SDL_strcmp(format, "y4m") == 0) {
+        options->format = CAPTURE_Y4M;
+    } else if (SDL_strcmp(format, "rgb") == 0) {
+        options->format = CAPTURE_RGB;
+    } else {
+        SDL_Log("--format must be y4m or rgb");
+        return false;
+    }
+
+    if (options->seconds == 0 && options->replay_path == NULL) {
+        options->seconds = 30;
+    }
+    if (options->width <= 0 || options->height <= 0 || options->fps <= 0 || options->seconds < 0) {
+        SDL_Log("--size and --fps must be positive, and --seconds not negative");
+        return false;
+    }
+    if (options->format == CAPTURE_Y4M && (options->width % 2 != 0 || options->height % 2 != 0)) {
+        SDL_Log("y4m needs an even width and height");
+        return false;
+    }
+    return true;
+}
+
+static int writer_thread(void *data) {
+    CaptureQueue *queue = (CaptureQueue *) data;
+    const SDL_PixelFormat format = queue->format == CAPTURE_Y4M ? SDL_PIXELFORMAT_IYUV : SDL_PIXELFORMAT_RGB24;
+    const int pitch = queue->format == CAPTURE_Y4M ? queue->width : queue->width * 3;
+
+    for (int slot = 0; ; slot = (slot + 1) % CAPTURE_QUEUE_FRAMES) {
+        const Uint64 wait_start = SDL_GetTicksNS();
+        SDL_WaitSemaphore(queue->full_slots);
+        const Uint64 convert_start = SDL_GetTicksNS();
+        queue->wait_ns += convert_start - wait_start;
+        if (queue->end[slot]) {
+            break;
+        }
+
+        // After a failed write, keep emptying slots so the renderer never blocks on a full ring
+        if (!queue->failed.load()) {
+            SDL_ConvertPixelsAndColorspace(queue->width, queue->height,
+                                           SDL_PIXELFORMAT_XRGB8888, SDL_COLORSPACE_SRGB, 0,
+                                           queue->frames[slot], queue->width * 4,
+                                           format, SDL_COLORSPACE_BT601_LIMITED, 0,
+                                           queue->converted, pitch);
+            const Uint64 write_start = SDL_GetTicksNS();
+            queue->convert_ns += write_start - convert_start;
+
+            static const char frame_header[] = "FRAME\n";
+            bool ok = true;
+            if (queue->format == CAPTURE_Y4M) {
+                ok = SDL_WriteIO(queue->io, frame_header, sizeof(frame_header) - 1) == sizeof(frame_header) - 1;
+            }
+            ok = ok && SDL_WriteIO(queue->io, queue->converted, queue->converted_size) == queue->converted_size;
+            queue->write_ns += SDL_GetTicksNS() - write_start;
+            if (ok) {
+                queue->frames_written++;
+            } else {
+                SDL_Log("Couldn't write frame %" SDL_PRIu64 ": %s", queue->frames_written, SDL_GetError());
+                queue->failed.store(true);
+            }
+        }
+        SDL_SignalSemaphore(queue->free_slots);
+    }
+    return 0;
+}
+
+static bool queue_create(CaptureQueue *queue, const CaptureOptions *options, SDL_IOStream *io) {
+    queue->width = options->width;
+    queue->height = options->height;
+    queue->format = options->format;
+    queue->io = io;
+    queue->failed.store(false);
+    queue->frames_written = 0;
+    queue->convert_ns = 0;
+    queue->write_ns = 0;
+    queue->wait_ns = 0;
+
+    const size_t pixels = (size_t) options->width * options->height;
+    const size_t frame_size = pixels * 4;
+    queue->converted_size = options->format == CAPTURE_Y4M ? pixels * 3 / 2 : pixels * 3;
+
+    // One allocation for the ring and the converted frame
+    Uint8 *memory = (Uint8 *) SDL_malloc(CAPTURE_QUEUE_FRAMES * frame_size + queue->converted_size);
+    queue->free_slots = SDL_CreateSemaphore(CAPTURE_QUEUE_FRAMES);
+    queue->full_slots = SDL_CreateSemaphore(0);
+    if (!memory || !queue->free_slots || !queue->full_slots) {
+        SDL_free(memory);
+        SDL_DestroySemaphore(queue->free_slots);
+        SDL_DestroySemaphore(queue->full_slots);
+        return false;
+    }
+    for (int i = 0; i < CAPTURE_QUEUE_FRAMES; i++) {
+        queue->frames[i] = memory + i * frame_size;
+        queue->end[i] = false;
+    }
+    queue->converted = memory + CAPTURE_QUEUE_FRAMES * frame_size;
+    return true;
+}
+
+static void queue_destroy(CaptureQueue *queue) {
+    SDL_free(queue->frames[0]);
+    SDL_DestroySemaphore(queue->free_slots);
+    SDL_DestroySemaphore(queue->full_slots);
+}
+
+static void render_frame(SDL_Renderer *renderer, const Match *match) {
+    // Clear the whole surface, as the letterbox bars are outside the court
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(renderer);
+
+    GameView view;
+    view.position_player_y = match->position_player_y;
+    view.position_cpu_y = match->position_cpu_y;
+    view.position_ball_x = match->position_ball_x;
+    view.position_ball_y = match->position_ball_y;
+    view.score_player = match->score_player;
+    view.score_cpu = match->score_cpu;
+    scene_render_game(renderer, &view);
+    SDL_RenderPresent(renderer);
+}
+
+static SDL_AppResult export_video(const CaptureOptions *options, SDL_Renderer *renderer, SDL_Surface *surface,
+                                  CaptureQueue *queue) {
+    Match match;
+    ReplayReader replay;
+    SDL_zero(replay);
+    Uint32 tick_rate = SIM_TICK_RATE;
+    float dt = SIM_DT;
+    Uint64 tick_count = 0;      // Where to stop; 0 for the end of the replay
+    if (options->replay_path != NULL) {
+        if (!replay_reader_open(&replay, options->replay_path) || !replay_reader_seek(&replay, 0, &match)) {
+            replay_reader_close(&replay);
+            return SDL_APP_FAILURE;
+        }
+        tick_rate = replay.tick_rate;
+        dt = replay_reader_dt(&replay);
+    } else {
+        MatchConfig config;
+        match_default_config(&config);
+        match_init(&match, &config, options->seed);
+    }
+    tick_count = (Uint64) (options->seconds * tick_rate);
+
+    SDL_AppResult result = SDL_APP_SUCCESS;
+    Uint64 ticks = 0;
+    Uint64 frames = 0;
+    Uint64 render_ns = 0;
+    Uint64 wait_ns = 0;         // For the writer to free a slot
+    const Uint64 start = SDL_GetTicksNS();
+    for (bool more = true; more && !queue->failed.load(); frames++) {
+        // Step to the last tick at or before this frame's time
+        const Uint64 frame_tick = frames * tick_rate / options->fps;
+        if (tick_count > 0 && frame_tick >= tick_count) {
+            break;
+        }
+        while (more && ticks < frame_tick) {
+            if (options->replay_path != NULL) {
+                more = replay_reader_advance(&replay, &match);
+            } else {
+                match.direction_player = match_autoplay_direction(&match);
+            }
+            if (more) {
+                match_step(&match, dt);
+                ticks++;
+            }
+        }
+        if (!more) {
+            break;
+        }
+
+        const Uint64 render_start = SDL_GetTicksNS();
+        render_frame(renderer, &match);
+        const Uint64 render_end = SDL_GetTicksNS();
+        render_ns += render_end - render_start;
+
+        const int slot = (int) (frames % CAPTURE_QUEUE_FRAMES);
+        SDL_WaitSemaphore(queue->free_slots);
+        wait_ns += SDL_GetTicksNS() - render_end;
+        const int row_size = options->width * 4;
+        for (int y = 0; y < options->height; y++) {
+            SDL_memcpy(queue->frames[slot] + y * row_size, (const Uint8 *) surface->pixels + y * surface->pitch, row_size);
+        }
+        SDL_SignalSemaphore(queue->full_slots);
+    }
+
+    // Hand over the end marker and let the writer drain the ring
+    const int slot = (int) (frames % CAPTURE_QUEUE_FRAMES);
+    SDL_WaitSemaphore(queue->free_slots);
+    queue->end[slot] = true;
+    SDL_SignalSemaphore(queue->full_slots);
+
+    if (options->replay_path != NULL) {
+        if (replay.desyncs > 0) {
+            SDL_Log("Replay has %d desynced keyframes", replay.desyncs);
+        }
+        replay_reader_close(&replay);
+    }
+    if (queue->failed.load()) {
+        result = SDL_APP_FAILURE;
+    }
+
+    const Uint64 elapsed_ns = SDL_GetTicksNS() - start;
+    const double seconds = (double) elapsed_ns / SDL_NS_PER_SECOND;
+    const double video_seconds = (double) frames / options->fps;
+    SDL_Log("Exported %" SDL_PRIu64 " frames (%.1f s of video) in %.2f s: %.1f fps, %.1fx real time",
+            frames, video_seconds, seconds, seconds > 0 ? frames / seconds : 0.0,
+            seconds > 0 ? video_seconds / seconds : 0.0);
+    if (frames > 0) {
+        SDL_Log("Per frame: render %.2f ms, waiting for the writer %.2f ms",
+                (double) render_ns / frames / SDL_NS_PER_MS, (double) wait_ns / frames / SDL_NS_PER_MS);
+    }
+    return result;
+}
+
+SDL_AppResult capture_run(int argc, char *argv[]) {
+    CaptureOptions options;
+    if (!parse_options(argc, argv, &options)) {
+        return SDL_APP_FAILURE;
+    }
+
+    SDL_Surface *surface = SDL_CreateSurface(options.width, options.height, SDL_PIXELFORMAT_XRGB8888);
+    SDL_Renderer *renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    if (!renderer) {
+        SDL_Log("Couldn't create software renderer: %s", SDL_GetError());
+        SDL_DestroySurface(surface);
+        return SDL_APP_FAILURE;
+    }
+    SDL_SetRenderLogicalPresentation(renderer, GAME_WIDTH, GAME_HEIGHT, SDL_LOGICAL_PRESENTATION_LETTERBOX);
+    if (!scene_init()) {
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroySurface(surface);
+        return SDL_APP_FAILURE;
+    }
+
+    SDL_AppResult result = SDL_APP_FAILURE;
+    SDL_IOStream *io = SDL_IOFromFile(options.path, "wb");
+    if (!io) {
+        SDL_Log("Couldn't open %s: %s", options.path, SDL_GetError());
+    } else {
+        bool ok = true;
+        if (options.format == CAPTURE_Y4M) {
+            // 'C420jpeg' is 4:2:0 with chroma sited between the luma samples, as SDL converts it
+            ok = SDL_IOprintf(io, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n",
+                              options.width, options.height, options.fps) > 0;
+        }
+
+        CaptureQueue queue;
+        if (!ok) {
+            SDL_Log("Couldn't write to %s: %s", options.path, SDL_GetError());
+        } else if (!queue_create(&queue, &options, io)) {
+            SDL_Log("Couldn't allocate the frame queue");
+        } else {
+            SDL_Thread *writer = SDL_CreateThread(writer_thread, "capture writer", &queue);
+            if (!writer) {
+                SDL_Log("Couldn't start writer thread: %s", SDL_GetError());
+            } else {
+                SDL_Log("Exporting %dx%d at %d fps to %s (%s)", options.width, options.height, options.fps,
+                        options.path, options.format == CAPTURE_Y4M ? "y4m" : "rgb");
+                result = export_video(&options, renderer, surface, &queue);
+                SDL_WaitThread(writer, NULL);
+                if (queue.frames_written > 0) {
+                    SDL_Log("Writer per frame: convert %.2f ms, write %.2f ms, waiting for frames %.2f ms",
+                            (double) queue.convert_ns / queue.frames_written / SDL_NS_PER_MS,
+                            (double) queue.write_ns / queue.frames_written / SDL_NS_PER_MS,
+                            (double) queue.wait_ns / queue.frames_written / SDL_NS_PER_MS);
+                }
+            }
+            queue_destroy(&queue);
+        }
+        if (!SDL_CloseIO(io)) {
+            SDL_Log("Couldn't finish %s: %s", options.path, SDL_GetError());
+            result = SDL_APP_FAILURE;
+        }
+    }
+
+    scene_quit();
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroySurface(surface);
+    return result;
+}
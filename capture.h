@@ -0,0 +1,18 @@
+/* Video export: render the GAME scene of a replay, or of an autoplayed match, with the
+ * software renderer into an offscreen surface and write the frames out as YUV4MPEG2 or
+ * raw RGB24, to a file or a pipe into an encoder. No window, GPU or audio device is
+ * needed. Frames are written by a thread of their own while the next ones render.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <SDL3/SDL.h>
+
+// True if the command line asks for a video export
+bool capture_requested(int argc, char *argv[]);
+
+// Run the export described by the command line
+SDL_AppResult capture_run(int argc, char *argv[]);
+
+#endif
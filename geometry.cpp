@@ -0,0 +1,75 @@
+#include "geometry.h"
+
+SDL_FColor geometry_color(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+    SDL_FColor color = {r / 255.0f, g / 255.0f, b / 255.0f, a / 255.0f};
+    return color;
+}
+
+bool geometry_create(Geometry *geometry, int max_quads) {
+    SDL_zerop(geometry);
+    geometry->vertices = (SDL_Vertex *) SDL_malloc(max_quads * 4 * sizeof(SDL_Vertex));
+    geometry->indices = (int *) SDL_malloc(max_quads * 6 * sizeof(int));
+    if (!geometry->vertices || !geometry->indices) {
+        geometry_destroy(geometry);
+        return false;
+    }
+
+    // Every quad is two triangles over its own four vertices, so indices never change
+    for (int quad = 0; quad < max_quads; quad++) {
+        int *index = &geometry->indices[quad * 6];
+        const int first = quad * 4;
+        index[0] = first;
+        index[1] = first + 1;
+        index[2] = first + 2;
+        index[3] = first + 2;
+        index[4] = first + 3;
+        index[5] = first;
+    }
+    geometry->max_quads = max_quads;
+    return true;
+}
+
+void geometry_destroy(Geometry *geometry) {
+    SDL_free(geometry->vertices);
+    SDL_free(geometry->indices);
+    SDL_zerop(geometry);
+}
+
+void geometry_clear(Geometry *geometry) {
+    geometry->quad_count = 0;
+}
+
+bool geometry_add_textured_rect(Geometry *geometry, const SDL_FRect *rect, const SDL_FRect *uv, SDL_FColor color) {
+    if (geometry->quad_count == geometry->max_quads) {
+        return false;
+    }
+
+    // Corners clockwise from top-left
+    SDL_Vertex *vertex = &geometry->vertices[geometry->quad_count * 4];
+    const float x[4] = {rect->x, rect->x + rect->w, rect->x + rect->w, rect->x};
+    const float y[4] = {rect->y, rect->y, rect->y + rect->h, rect->y + rect->h};
+    const float u[4] = {uv->x, uv->x + uv->w, uv->x + uv->w, uv->x};
+    const float v[4] = {uv->y, uv->y, uv->y + uv->h, uv->y + uv->h};
+    for (int i = 0; i < 4; i++) {
+        vertex[i].position.x = x[i];
+        vertex[i].position.y = y[i];
+        vertex[i].color = color;
+        vertex[i].tex_coord.x = u[i];
+        vertex[i].tex_coord.y = v[i];
+    }
+    geometry->quad_count++;
+    return true;
+}
+
+bool geometry_add_rect(Geometry *geometry, const SDL_FRect *rect, SDL_FColor color) {
+    const SDL_FRect uv = {0, 0, 0, 0};
+    return geometry_add_textured_rect(geometry, rect, &uv, color);
+}
+
+bool geometry_draw(const Geometry *geometry, SDL_Renderer *renderer, SDL_Texture *texture) {
+    if (geometry->quad_count == 0) {
+        return true;
+    }
+    return SDL_RenderGeometry(renderer, texture, geometry->vertices, geometry->quad_count * 4,
+                              geometry->indices, geometry->quad_count * 6);
+}
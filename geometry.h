@@ -0,0 +1,35 @@
+/* Geometry: a preallocated buffer of coloured (optionally textured) quads that is
+ * filled during a frame and submitted with a single SDL_RenderGeometry() call.
+ */
+
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <SDL3/SDL.h>
+
+typedef struct Geometry {
+    SDL_Vertex *vertices;       // Four per quad
+    int *indices;               // Six per quad, filled once by geometry_create()
+    int max_quads;
+    int quad_count;
+} Geometry;
+
+// Convert an 8-bit colour as used by SDL_SetRenderDrawColor()
+SDL_FColor geometry_color(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+
+bool geometry_create(Geometry *geometry, int max_quads);
+void geometry_destroy(Geometry *geometry);
+
+// Start collecting a new set of quads
+void geometry_clear(Geometry *geometry);
+
+// Add a solid rectangle; false (and nothing added) once the buffer is full
+bool geometry_add_rect(Geometry *geometry, const SDL_FRect *rect, SDL_FColor color);
+
+// Add a rectangle showing 'uv' (normalised texture coordinates), tinted by 'color'
+bool geometry_add_textured_rect(Geometry *geometry, const SDL_FRect *rect, const SDL_FRect *uv, SDL_FColor color);
+
+// Draw everything collected so far in one call, with 'texture' or none
+bool geometry_draw(const Geometry *geometry, SDL_Renderer *renderer, SDL_Texture *texture);
+
+#endif
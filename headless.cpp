@@ -0,0 +1,315 @@
+#include "headless.h"
+#include "match.h"
+#include "batch.h"
+#include "replay.h"
+
+/* Usage:
+ *   pong --headless [--matches N] [--points N] [--seed S] [--dt SECONDS]
+ *                   [--ball-speed M] [--paddle-speed M] [--cpu-speed PX]
+ *                   [--cpu-level L] [--record FILE]
+ *   pong --headless --batch [--matches N] [--steps N] [--seed S] [--dt SECONDS]
+ *   pong --headless --replay FILE
+ *
+ * With --batch, all matches are stepped together by the SIMD kernel in batch.cpp for a
+ * fixed number of steps, once per instruction set the CPU supports, and each run is
+ * checked against match_step() before its throughput is reported.
+ *
+ * --cpu-level (0 to 2) plays the predicting CPU instead of the ping-pong one; the batch
+ * kernel only has the latter.
+ *
+ * --record saves the first match as a replay; --replay re-simulates one to the end,
+ * checking every keyframe, and times a seek to a few points in it.
+ */
+
+typedef struct HeadlessOptions {
+    int matches;
+    int points;         // First to this many points wins the match
+    Uint64 seed;
+    float dt;
+    MatchConfig config;
+    bool batch;
+    int steps;          // Steps per match with --batch
+    const char *record_path;
+    const char *replay_path;
+} HeadlessOptions;
+
+bool headless_requested(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (SDL_strcmp(argv[i], "--headless") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_options(int argc, char *argv[], HeadlessOptions *options) {
+    options->matches = 100;
+    options->points = 11;
+    options->seed = 1;
+    options->dt = SIM_DT;
+    match_default_config(&options->config);
+    options->batch = false;
+    options->steps = 10000;
+    options->record_path = NULL;
+    options->replay_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (SDL_strcmp(arg, "--headless") == 0) {
+            continue;
+        } else if (SDL_strcmp(arg, "--batch") == 0) {
+            options->batch = true;
+            continue;
+        }
+        if (value == NULL) {
+            SDL_Log("Missing value for '%s'", arg);
+            return false;
+        }
+
+        if (SDL_strcmp(arg, "--matches") == 0) {
+            options->matches = SDL_atoi(value);
+        } else if (SDL_strcmp(arg, "--steps") == 0) {
+            options->steps = SDL_atoi(value);
+        } else if (SDL_strcmp(arg, "--points") == 0) {
+            options->points = SDL_atoi(value);
+        } else if (SDL_strcmp(arg, "--seed") == 0) {
+            options->seed = SDL_strtoull(value, NULL, 0);
+        } else if (SDL_strcmp(arg, "--dt") == 0) {
+            options->dt = (float) SDL_atof(value);
+        } else if (SDL_strcmp(arg, "--ball-speed") == 0) {
+            options->config.ball_speed_multiplier = (float) SDL_atof(value);
+        } else if (SDL_strcmp(arg, "--paddle-speed") == 0) {
+            options->config.paddle_speed_multiplier = (float) SDL_atof(value);
+        } else if (SDL_strcmp(arg, "--cpu-speed") == 0) {
+            options->config.cpu_speed = (float) SDL_atof(value);
+        } else if (SDL_strcmp(arg, "--cpu-level") == 0) {
+            const int level = SDL_atoi(value);
+            if (level < 0 || level >= MATCH_CPU_LEVELS) {
+                SDL_Log("--cpu-level must be between 0 and %d", MATCH_CPU_LEVELS - 1);
+                return false;
+            }
+            match_set_cpu_level(&options->config, level);
+        } else if (SDL_strcmp(arg, "--record") == 0) {
+            options->record_path = value;
+        } else if (SDL_strcmp(arg, "--replay") == 0) {
+            options->replay_path = value;
+        } else {
+            SDL_Log("Unknown headless option '%s'", arg);
+            return false;
+        }
+        i++;
+    }
+
+    if (options->matches <= 0 || options->points <= 0 || options->steps <= 0 || options->dt <= 0) {
+        SDL_Log("--matches, --points, --steps and --dt must be positive");
+        return false;
+    }
+    if (options->batch && options->config.cpu_control != CPU_PING_PONG) {
+        SDL_Log("--batch only plays the ping-pong CPU; leave out --cpu-level");
+        return false;
+    }
+    if (options->record_path != NULL && options->dt != SIM_DT) {
+        SDL_Log("--record needs the game's own tick rate; leave out --dt");
+        return false;
+    }
+    return true;
+}
+
+static bool same_match(const Match *a, const Match *b) {
+    return a->position_player_y == b->position_player_y &&
+           a->position_cpu_y == b->position_cpu_y &&
+           a->position_ball_x == b->position_ball_x &&
+           a->position_ball_y == b->position_ball_y &&
+           a->component_ball_x == b->component_ball_x &&
+           a->direction_player == b->direction_player &&
+           a->direction_cpu == b->direction_cpu &&
+           a->direction_ball_x == b->direction_ball_x &&
+           a->direction_ball_y == b->direction_ball_y &&
+           a->score_player == b->score_player &&
+           a->score_cpu == b->score_cpu &&
+           a->rng_state == b->rng_state;
+}
+
+static void reset_batch(MatchBatch *batch, const HeadlessOptions *options) {
+    for (int i = 0; i < batch->count; i++) {
+        Match match;
+        match_init(&match, &options->config, match_seed(options->seed, i));
+        batch_set_match(batch, i, &match);
+    }
+}
+
+static SDL_AppResult run_batch(const HeadlessOptions *options) {
+    MatchBatch batch;
+    if (!batch_create(&batch, options->matches)) {
+        SDL_Log("Couldn't allocate batch of %d matches", options->matches);
+        return SDL_APP_FAILURE;
+    }
+
+    // Reference result: every match stepped on its own by match_step()
+    Match *expected = (Match *) SDL_malloc(options->matches * sizeof(Match));
+    if (!expected) {
+        batch_destroy(&batch);
+        return SDL_APP_FAILURE;
+    }
+    for (int i = 0; i < options->matches; i++) {
+        match_init(&expected[i], &options->config, match_seed(options->seed, i));
+        for (int step = 0; step < options->steps; step++) {
+            expected[i].direction_player = match_autoplay_direction(&expected[i]);
+            match_step(&expected[i], options->dt);
+        }
+    }
+
+    SDL_Log("Headless batch: %d matches x %d steps, seed %" SDL_PRIu64 ", dt %g s",
+            options->matches, options->steps, options->seed, options->dt);
+
+    SDL_AppResult result = SDL_APP_SUCCESS;
+    const BatchIsa isas[] = {BATCH_ISA_SCALAR, BATCH_ISA_SSE2, BATCH_ISA_AVX2};
+    for (size_t n = 0; n < SDL_arraysize(isas); n++) {
+        if (!batch_isa_supported(isas[n])) {
+            SDL_Log("%-6s not supported", batch_isa_name(isas[n]));
+            continue;
+        }
+
+        reset_batch(&batch, options);
+        const Uint64 start = SDL_GetTicksNS();
+        for (int step = 0; step < options->steps; step++) {
+            batch_autoplay(&batch);
+            batch_step(&batch, options->dt, isas[n]);
+        }
+        const double seconds = (double) (SDL_GetTicksNS() - start) / SDL_NS_PER_SECOND;
+
+        int mismatches = 0;
+        for (int i = 0; i < options->matches; i++) {
+            Match match;
+            batch_get_match(&batch, i, &match);
+            if (!same_match(&match, &expected[i])) {
+                mismatches++;
+            }
+        }
+        if (mismatches > 0) {
+            result = SDL_APP_FAILURE;
+        }
+
+        const double match_steps = (double) options->matches * options->steps;
+        SDL_Log("%-6s %.0f match-steps/s (%.3f s), %d mismatches against match_step()",
+                batch_isa_name(isas[n]), seconds > 0 ? match_steps / seconds : 0.0, seconds, mismatches);
+    }
+
+    SDL_free(expected);
+    batch_destroy(&batch);
+    return result;
+}
+
+// Play the first match again the way headless_run() does, saving it as a replay
+static bool record_match(const HeadlessOptions *options, Uint64 max_ticks) {
+    Match match;
+    match_init(&match, &options->config, match_seed(options->seed, 0));
+
+    ReplayWriter writer;
+    if (!replay_writer_open(&writer, options->record_path, &match, options->seed)) {
+        return false;
+    }
+    for (Uint64 tick = 0; match.score_player < options->points && match.score_cpu < options->points && tick < max_ticks; tick++) {
+        match.direction_player = match_autoplay_direction(&match);
+        replay_writer_tick(&writer, &match);
+        match_step(&match, options->dt);
+    }
+    return replay_writer_close(&writer);
+}
+
+static SDL_AppResult run_replay(const char *path) {
+    ReplayReader reader;
+    if (!replay_reader_open(&reader, path)) {
+        return SDL_APP_FAILURE;
+    }
+
+    Match match;
+    const float dt = replay_reader_dt(&reader);
+    Uint64 start = SDL_GetTicksNS();
+    bool ok = replay_reader_seek(&reader, 0, &match);
+    while (ok && replay_reader_advance(&reader, &match)) {
+        match_step(&match, dt);
+    }
+    const double seconds = (double) (SDL_GetTicksNS() - start) / SDL_NS_PER_SECOND;
+
+    SDL_Log("Replay: %.1f s, seed %" SDL_PRIu64 ", %" SDL_PRIu32 " keyframes, final score %d-%d",
+            replay_reader_duration(&reader), reader.seed, reader.keyframe_count, match.score_player, match.score_cpu);
+    SDL_Log("Re-simulated in %.3f s, %d desynced keyframes", seconds, reader.desyncs);
+    const int desyncs = reader.desyncs;
+
+    // Seeking costs the same wherever it lands
+    for (int i = 1; ok && i <= 4; i++) {
+        const Uint32 tick = (Uint32) ((Uint64) reader.tick_count * i / 4);
+        start = SDL_GetTicksNS();
+        ok = replay_reader_seek(&reader, tick, &match);
+        SDL_Log("Seek to %.1f s took %.3f ms", (float) tick / reader.tick_rate,
+                (double) (SDL_GetTicksNS() - start) / SDL_NS_PER_MS);
+    }
+
+    replay_reader_close(&reader);
+    return (ok && desyncs == 0) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+}
+
+SDL_AppResult headless_run(int argc, char *argv[]) {
+    HeadlessOptions options;
+    if (!parse_options(argc, argv, &options)) {
+        return SDL_APP_FAILURE;
+    }
+
+    if (options.batch) {
+        return run_batch(&options);
+    }
+
+    if (options.replay_path != NULL) {
+        return run_replay(options.replay_path);
+    }
+
+    const Uint64 max_ticks = (Uint64) (MATCH_PLAY_MAX_SECONDS / options.dt);
+    if (options.record_path != NULL && !record_match(&options, max_ticks)) {
+        return SDL_APP_FAILURE;
+    }
+
+    Uint64 total_ticks = 0;
+    Uint64 total_points = 0;
+    Uint64 total_rallies = 0;
+    int player_wins = 0;
+    int cpu_wins = 0;
+    int unfinished = 0;
+
+    const Uint64 start = SDL_GetTicksNS();
+
+    for (int i = 0; i < options.matches; i++) {
+        Match match;
+        match_init(&match, &options.config, match_seed(options.seed, i));
+
+        MatchSummary summary;
+        match_play(&match, options.points, options.dt, max_ticks, &summary);
+
+        total_ticks += summary.ticks;
+        total_rallies += summary.returns;
+        total_points += match.score_player + match.score_cpu;
+        if (match.score_player >= options.points) {
+            player_wins++;
+        } else if (match.score_cpu >= options.points) {
+            cpu_wins++;
+        } else {
+            unfinished++;
+        }
+    }
+
+    const double seconds = (double) (SDL_GetTicksNS() - start) / SDL_NS_PER_SECOND;
+
+    SDL_Log("Headless: %d matches to %d points, seed %" SDL_PRIu64 ", dt %g s",
+            options.matches, options.points, options.seed, options.dt);
+    SDL_Log("Player wins %d, CPU wins %d, unfinished %d", player_wins, cpu_wins, unfinished);
+    SDL_Log("%" SDL_PRIu64 " ticks (%.1f s simulated), %" SDL_PRIu64 " points, %" SDL_PRIu64 " paddle returns",
+            total_ticks, total_ticks * options.dt, total_points, total_rallies);
+    if (seconds > 0) {
+        SDL_Log("Wall time %.3f s: %.0f ticks/s, %.0f rallies/s, %.0f points/s",
+                seconds, total_ticks / seconds, total_rallies / seconds, total_points / seconds);
+    }
+
+    return SDL_APP_SUCCESS;
+}
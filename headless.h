@@ -0,0 +1,16 @@
+/* Headless simulation: run whole matches as fast as the CPU allows, with no window,
+ * renderer or audio device, and report throughput. Used for balance regression runs.
+ */
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <SDL3/SDL.h>
+
+// True if the command line asks for headless mode
+bool headless_requested(int argc, char *argv[]);
+
+// Run the headless simulation described by the command line
+SDL_AppResult headless_run(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,73 @@
+#include "loader.h"
+#include "trace.h"
+
+static int SDLCALL loader_thread(void *data) {
+    AssetLoader *loader = (AssetLoader *) data;
+    trace_thread_name("loader");
+    for (int i = 0; i < loader->count; i++) {
+        LoadJob *job = &loader->jobs[i];
+        TRACE_ZONE(job->name);
+        const bool loaded = !loader->cancelled.load() && job->function(job->userdata);
+        job->finished_ns = SDL_GetTicksNS();
+        if (!loaded && !loader->cancelled.load()) {
+            SDL_Log("Couldn't load %s, carrying on without it", job->name);
+        }
+        job->state.store(loaded ? LOAD_DONE : LOAD_FAILED, std::memory_order_release);
+    }
+    return 0;
+}
+
+void loader_init(AssetLoader *loader) {
+    loader->thread = NULL;
+    loader->count = 0;
+    loader->cancelled.store(false);
+}
+
+int loader_add(AssetLoader *loader, const char *name, LoadFunction function, void *userdata) {
+    if (loader->thread != NULL || loader->count >= LOADER_MAX_JOBS) {
+        return -1;
+    }
+    LoadJob *job = &loader->jobs[loader->count];
+    job->name = name;
+    job->function = function;
+    job->userdata = userdata;
+    job->state.store(LOAD_PENDING);
+    job->finished_ns = 0;
+    return loader->count++;
+}
+
+bool loader_start(AssetLoader *loader) {
+    loader->thread = SDL_CreateThread(loader_thread, "loader", loader);
+    if (!loader->thread) {
+        SDL_Log("Couldn't start loader thread: %s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+LoadState loader_state(const AssetLoader *loader, int job) {
+    if (job < 0 || job >= loader->count) {
+        return LOAD_FAILED;
+    }
+    return (LoadState) loader->jobs[job].state.load(std::memory_order_acquire);
+}
+
+bool loader_ready(const AssetLoader *loader, int job) {
+    return loader_state(loader, job) == LOAD_DONE;
+}
+
+bool loader_finished(const AssetLoader *loader) {
+    return loader->count == 0 || loader_state(loader, loader->count - 1) != LOAD_PENDING;
+}
+
+Uint64 loader_finished_ns(const AssetLoader *loader) {
+    return loader->count == 0 ? 0 : loader->jobs[loader->count - 1].finished_ns;
+}
+
+void loader_finish(AssetLoader *loader) {
+    if (loader->thread) {
+        loader->cancelled.store(true);
+        SDL_WaitThread(loader->thread, NULL);
+        loader->thread = NULL;
+    }
+}
@@ -0,0 +1,58 @@
+/* Background asset loading: jobs are queued before the loader starts, then run one after
+ * another on their own thread while the game keeps drawing frames. Each job's state works
+ * as a future: the game polls it and uses the asset only once it is LOAD_DONE, which also
+ * makes everything the job wrote visible to the polling thread.
+ */
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <SDL3/SDL.h>
+#include <atomic>
+
+const int LOADER_MAX_JOBS = 16;
+
+enum LoadState {
+    LOAD_PENDING = 0,
+    LOAD_DONE,
+    LOAD_FAILED
+};
+
+// Runs on the loader thread; false if the asset couldn't be loaded
+typedef bool (*LoadFunction)(void *userdata);
+
+typedef struct LoadJob {
+    const char *name;
+    LoadFunction function;
+    void *userdata;
+    std::atomic<int> state;     // LoadState
+    Uint64 finished_ns;         // SDL_GetTicksNS() when it finished; valid once not pending
+} LoadJob;
+
+typedef struct AssetLoader {
+    SDL_Thread *thread;
+    LoadJob jobs[LOADER_MAX_JOBS];
+    int count;
+    std::atomic<bool> cancelled;
+} AssetLoader;
+
+void loader_init(AssetLoader *loader);
+
+// Queue a job, before loader_start(); returns its id for loader_state(), or -1 if full
+int loader_add(AssetLoader *loader, const char *name, LoadFunction function, void *userdata);
+
+// Run the queued jobs in order on a new thread
+bool loader_start(AssetLoader *loader);
+
+LoadState loader_state(const AssetLoader *loader, int job);
+
+bool loader_ready(const AssetLoader *loader, int job);
+
+// Whether every job has finished, and when the last one did
+bool loader_finished(const AssetLoader *loader);
+Uint64 loader_finished_ns(const AssetLoader *loader);
+
+// Skip whatever hasn't started and wait for the running job to finish
+void loader_finish(AssetLoader *loader);
+
+#endif
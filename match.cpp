@@ -0,0 +1,340 @@
+#include "match.h"
+
+void match_default_config(MatchConfig *config) {
+    config->ball_speed_multiplier = 0.5;
+    config->paddle_speed_multiplier = 0.5;
+    config->cpu_speed = 250;
+    config->cpu_control = CPU_PING_PONG;
+    config->cpu_reaction = 0;
+    config->cpu_error = 0;
+}
+
+void match_set_cpu_level(MatchConfig *config, int level) {
+    // LOW, MEDIUM, HIGH
+    static const float REACTION[MATCH_CPU_LEVELS] = {0.45f, 0.25f, 0.1f};
+    static const float ERROR[MATCH_CPU_LEVELS] = {70, 40, 20};
+    level = SDL_clamp(level, 0, MATCH_CPU_LEVELS - 1);
+    config->cpu_control = CPU_PREDICT;
+    config->cpu_reaction = REACTION[level];
+    config->cpu_error = ERROR[level];
+}
+
+void match_init(Match *match, const MatchConfig *config, Uint64 seed) {
+    match->config = *config;
+    match->rng_state = seed;
+
+    // Place player and CPU paddles little below upper wall
+    match->position_player_y = 100;
+    match->position_cpu_y = 100;
+
+    // Place ball in middle of screen
+    match->position_ball_x = GAME_WIDTH/2;
+    match->position_ball_y = GAME_HEIGHT/2;
+
+    // Set a random x (and by extension random y) between 0.0 and 1.0
+    match->component_ball_x = SDL_randf_r(&match->rng_state);
+
+    match->direction_player = ZERO;
+    match->direction_cpu = UP;
+    match->direction_ball_x = UP;
+    match->direction_ball_y = DOWN;
+
+    match->cpu_target_y = GAME_HEIGHT/2;
+    match->cpu_think_time = 0;
+
+    match->score_player = 0;
+    match->score_cpu = 0;
+}
+
+/* Time (as a fraction of the tick) at which the ball, moving by (velocity_x, velocity_y)
+ * per tick, first touches vertical face 'face_x' while its y is within [y_min, y_max].
+ * Returns false if that doesn't happen within 'time_left'. The ball is treated as a
+ * point at its top-left corner against paddles grown by the ball's size.
+ */
+static bool sweep_x_face(float face_x, float y_min, float y_max, float x, float y,
+                         float velocity_x, float velocity_y, float time_left, float *time) {
+    float t = (face_x - x) / velocity_x;
+    float y_at = y + velocity_y * t;
+    if (t >= 0 && t <= time_left && y_at >= y_min && y_at <= y_max) {
+        *time = t;
+        return true;
+    }
+    return false;
+}
+
+/* Same as sweep_x_face() for horizontal face 'face_y' and x within [x_min, x_max] */
+static bool sweep_y_face(float face_y, float x_min, float x_max, float x, float y,
+                         float velocity_x, float velocity_y, float time_left, float *time) {
+    float t = (face_y - y) / velocity_y;
+    float x_at = x + velocity_x * t;
+    if (t >= 0 && t <= time_left && x_at >= x_min && x_at <= x_max) {
+        *time = t;
+        return true;
+    }
+    return false;
+}
+
+/* Time at which the ball reaches wall 'wall_y'; walls are infinite, so a ball already
+ * past one bounces straight away */
+static bool sweep_wall(float wall_y, float y, float velocity_y, float time_left, float *time) {
+    float t = SDL_max((wall_y - y) / velocity_y, 0.0f);
+    if (t <= time_left) {
+        *time = t;
+        return true;
+    }
+    return false;
+}
+
+bool match_ball_intercept_y(const Match *match, float x, float *y) {
+    const MatchConfig *config = &match->config;
+    const float velocity_x = -400*match->direction_ball_x*match->component_ball_x*config->ball_speed_multiplier;
+    const float velocity_y = -400*match->direction_ball_y*(1 - match->component_ball_x)*config->ball_speed_multiplier;
+    const float t = (x - match->position_ball_x) / velocity_x;
+    if (velocity_x == 0 || t < 0) {
+        return false;
+    }
+
+    // The ball's top edge stays within [0, range]; a bounce mirrors it, so the path repeats every 2*range
+    const float range = GAME_HEIGHT - BALL_SIZE;
+    float folded = SDL_fmodf(match->position_ball_y + velocity_y * t, 2 * range);
+    if (folded < 0) {
+        folded += 2 * range;
+    }
+    *y = folded > range ? 2 * range - folded : folded;
+    return true;
+}
+
+// CPU_PREDICT: every cpu_reaction seconds pick where to be, then steer there
+static void cpu_think(Match *match, float dt) {
+    const MatchConfig *config = &match->config;
+    match->cpu_think_time -= dt;
+    if (match->cpu_think_time <= 0) {
+        match->cpu_think_time = config->cpu_reaction;
+
+        float intercept;
+        if (match_ball_intercept_y(match, PADDLE_CPU_X - BALL_SIZE, &intercept)) {
+            const float error = config->cpu_error * (2 * SDL_randf_r(&match->rng_state) - 1);
+            match->cpu_target_y = intercept + BALL_SIZE/2 + error;
+        } else {
+            // Ball is heading for the player; wait in the middle
+            match->cpu_target_y = GAME_HEIGHT/2;
+        }
+    }
+
+    // Small dead zone so the paddle doesn't jitter around its target
+    const float paddle_centre = match->position_cpu_y + PADDLE_HEIGHT/2;
+    if (match->cpu_target_y < paddle_centre - 4) {
+        match->direction_cpu = UP;
+    } else if (match->cpu_target_y > paddle_centre + 4) {
+        match->direction_cpu = DOWN;
+    } else {
+        match->direction_cpu = ZERO;
+    }
+}
+
+int match_step(Match *match, float dt) {
+    int events = MATCH_EVENT_NONE;
+    const MatchConfig *config = &match->config;
+
+    // Bound player to screen if exceeding window limit, else move player paddle
+    if (match->position_player_y < 0) {
+        match->position_player_y = 0;
+    } else if (match->position_player_y > GAME_HEIGHT-PADDLE_HEIGHT) {
+        match->position_player_y = GAME_HEIGHT-PADDLE_HEIGHT;
+    } else {
+        match->position_player_y -= 300*match->direction_player*dt*config->paddle_speed_multiplier;
+    }
+
+    if (config->cpu_control != CPU_PING_PONG) {
+        // Right paddle is steered like the player's; a second player moves it as fast
+        if (config->cpu_control == CPU_PREDICT) {
+            cpu_think(match, dt);
+        }
+        const float speed = config->cpu_control == CPU_REMOTE ? 300 : config->cpu_speed;
+        if (match->position_cpu_y < 0) {
+            match->position_cpu_y = 0;
+        } else if (match->position_cpu_y > GAME_HEIGHT-PADDLE_HEIGHT) {
+            match->position_cpu_y = GAME_HEIGHT-PADDLE_HEIGHT;
+        } else {
+            match->position_cpu_y -= speed*match->direction_cpu*dt*config->paddle_speed_multiplier;
+        }
+    } else {
+        // Move CPU vertically in ping-pong motion
+        match->position_cpu_y -= config->cpu_speed*match->direction_cpu*dt*config->paddle_speed_multiplier;
+        if (match->position_cpu_y < 0) {
+            match->direction_cpu = DOWN;
+        }
+
+        if (match->position_cpu_y > GAME_HEIGHT-PADDLE_HEIGHT) {
+            match->direction_cpu = UP;
+        }
+    }
+
+    // Reset x component to prevent ball getting stuck in one dimension
+    if (match->component_ball_x < 0.3 or match->component_ball_x > 0.7) {
+        match->component_ball_x = SDL_randf_r(&match->rng_state);
+    }
+    float component_ball_y = 1 - match->component_ball_x;
+
+    // Region each paddle blocks for the ball's top-left corner
+    const float player_y_min = match->position_player_y - BALL_SIZE;
+    const float player_y_max = match->position_player_y + PADDLE_HEIGHT;
+    const float cpu_y_min = match->position_cpu_y - BALL_SIZE;
+    const float cpu_y_max = match->position_cpu_y + PADDLE_HEIGHT;
+
+    /* Move the ball in a straight line up to the first wall or paddle it touches during
+       this tick, bounce, and carry on with whatever time is left. Checking the whole path
+       rather than just the end point keeps fast balls and long ticks from tunnelling. */
+    float time_left = 1;
+    for (int bounce = 0; bounce < MATCH_MAX_BOUNCES; bounce++) {
+        const float x = match->position_ball_x;
+        const float y = match->position_ball_y;
+        const float velocity_x = -400*match->direction_ball_x*match->component_ball_x*dt*config->ball_speed_multiplier;
+        const float velocity_y = -400*match->direction_ball_y*component_ball_y*dt*config->ball_speed_multiplier;
+
+        float t_top = 0, t_bottom = 0;
+        float t_player_face = 0, t_player_top = 0, t_player_bottom = 0;
+        float t_cpu_face = 0, t_cpu_top = 0, t_cpu_bottom = 0;
+
+        const bool hit_top = velocity_y < 0 && sweep_wall(0, y, velocity_y, time_left, &t_top);
+        const bool hit_bottom = velocity_y > 0 && sweep_wall(GAME_HEIGHT - BALL_SIZE, y, velocity_y, time_left, &t_bottom);
+
+        const bool hit_player_face = velocity_x < 0 && sweep_x_face(PADDLE_PLAYER_X + PADDLE_WIDTH, player_y_min, player_y_max,
+                x, y, velocity_x, velocity_y, time_left, &t_player_face);
+        const bool hit_player_top = velocity_y > 0 && sweep_y_face(player_y_min, PADDLE_PLAYER_X - BALL_SIZE, PADDLE_PLAYER_X + PADDLE_WIDTH,
+                x, y, velocity_x, velocity_y, time_left, &t_player_top);
+        const bool hit_player_bottom = velocity_y < 0 && sweep_y_face(player_y_max, PADDLE_PLAYER_X - BALL_SIZE, PADDLE_PLAYER_X + PADDLE_WIDTH,
+                x, y, velocity_x, velocity_y, time_left, &t_player_bottom);
+
+        const bool hit_cpu_face = velocity_x > 0 && sweep_x_face(PADDLE_CPU_X - BALL_SIZE, cpu_y_min, cpu_y_max,
+                x, y, velocity_x, velocity_y, time_left, &t_cpu_face);
+        const bool hit_cpu_top = velocity_y > 0 && sweep_y_face(cpu_y_min, PADDLE_CPU_X - BALL_SIZE, PADDLE_CPU_X + PADDLE_WIDTH,
+                x, y, velocity_x, velocity_y, time_left, &t_cpu_top);
+        const bool hit_cpu_bottom = velocity_y < 0 && sweep_y_face(cpu_y_max, PADDLE_CPU_X - BALL_SIZE, PADDLE_CPU_X + PADDLE_WIDTH,
+                x, y, velocity_x, velocity_y, time_left, &t_cpu_bottom);
+
+        // Earliest contact; several surfaces can share it (eg a paddle corner)
+        float t = time_left;
+        if (hit_top && t_top < t) {
+            t = t_top;
+        }
+        if (hit_bottom && t_bottom < t) {
+            t = t_bottom;
+        }
+        if (hit_player_face && t_player_face < t) {
+            t = t_player_face;
+        }
+        if (hit_player_top && t_player_top < t) {
+            t = t_player_top;
+        }
+        if (hit_player_bottom && t_player_bottom < t) {
+            t = t_player_bottom;
+        }
+        if (hit_cpu_face && t_cpu_face < t) {
+            t = t_cpu_face;
+        }
+        if (hit_cpu_top && t_cpu_top < t) {
+            t = t_cpu_top;
+        }
+        if (hit_cpu_bottom && t_cpu_bottom < t) {
+            t = t_cpu_bottom;
+        }
+
+        match->position_ball_x = x + velocity_x * t;
+        match->position_ball_y = y + velocity_y * t;
+        time_left = time_left - t;
+
+        const bool player_face = hit_player_face && t_player_face == t;
+        const bool cpu_face = hit_cpu_face && t_cpu_face == t;
+        const bool player_edge = (hit_player_top && t_player_top == t) || (hit_player_bottom && t_player_bottom == t);
+        const bool cpu_edge = (hit_cpu_top && t_cpu_top == t) || (hit_cpu_bottom && t_cpu_bottom == t);
+        const bool wall = (hit_top && t_top == t) || (hit_bottom && t_bottom == t);
+
+        const bool reflect_x = player_face || cpu_face;
+        const bool reflect_y = player_edge || cpu_edge || wall;
+        if (!reflect_x && !reflect_y) {
+            break;
+        }
+
+        if (player_face || player_edge) {
+            events |= MATCH_EVENT_HIT_PLAYER;
+        }
+        if (cpu_face || cpu_edge) {
+            events |= MATCH_EVENT_HIT_CPU;
+        }
+
+        if (reflect_x) {
+            match->direction_ball_x = static_cast<Directions>(-match->direction_ball_x);
+        }
+        if (reflect_y) {
+            match->direction_ball_y = static_cast<Directions>(-match->direction_ball_y);
+        } else if (player_face && match->direction_player != ZERO) {
+            // Change direction of ball to direction of paddle
+            match->direction_ball_y = match->direction_player;
+        } else if (cpu_face && match->direction_cpu != ZERO) {
+            match->direction_ball_y = match->direction_cpu;
+        }
+    }
+
+    // When ball crosses left or right side of screen and someone scores
+    if (match->position_ball_x < -20) {
+        match->position_ball_x = GAME_WIDTH/2;
+        match->position_ball_y = SDL_rand_r(&match->rng_state, (int) (GAME_HEIGHT - BALL_SIZE));
+        match->component_ball_x = SDL_randf_r(&match->rng_state);
+        match->direction_ball_x = UP;
+        match->score_cpu++;
+        events |= MATCH_EVENT_SCORE_CPU;
+    }
+
+    if (match->position_ball_x > GAME_WIDTH + 10) {
+        match->position_ball_x = GAME_WIDTH/2;
+        match->position_ball_y = SDL_rand_r(&match->rng_state, (int) (GAME_HEIGHT - BALL_SIZE));
+        match->component_ball_x = SDL_randf_r(&match->rng_state);
+        match->direction_ball_x = UP;
+        match->score_player++;
+        events |= MATCH_EVENT_SCORE_PLAYER;
+    }
+
+    return events;
+}
+
+void match_play(Match *match, int points, float dt, Uint64 max_ticks, MatchSummary *summary) {
+    SDL_zerop(summary);
+    int rally = 0;
+
+    while (match->score_player < points && match->score_cpu < points && summary->ticks < max_ticks) {
+        match->direction_player = match_autoplay_direction(match);
+        int events = match_step(match, dt);
+        if (events & (MATCH_EVENT_HIT_PLAYER | MATCH_EVENT_HIT_CPU)) {
+            summary->returns++;
+            rally++;
+        }
+        if (events & (MATCH_EVENT_SCORE_PLAYER | MATCH_EVENT_SCORE_CPU)) {
+            summary->longest_rally = SDL_max(summary->longest_rally, rally);
+            rally = 0;
+        }
+        summary->ticks++;
+    }
+    summary->longest_rally = SDL_max(summary->longest_rally, rally);
+}
+
+Directions match_autoplay_direction(const Match *match) {
+    float paddle_centre = match->position_player_y + PADDLE_HEIGHT/2;
+    float ball_centre = match->position_ball_y + BALL_SIZE/2;
+
+    // Small dead zone so the paddle doesn't jitter around the ball
+    if (ball_centre < paddle_centre - 8) {
+        return UP;
+    } else if (ball_centre > paddle_centre + 8) {
+        return DOWN;
+    }
+    return ZERO;
+}
+
+Uint64 match_seed(Uint64 base, Uint64 index) {
+    // splitmix64 finaliser
+    Uint64 z = base + (index + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
@@ -0,0 +1,126 @@
+/* State and rules of a single Pong match, independent of window, renderer and audio.
+ * The interactive game, headless runs and any other simulation all step a Match.
+ */
+
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <SDL3/SDL.h>
+
+// Actual game's resolution
+const int GAME_WIDTH = 640;
+const int GAME_HEIGHT = 480;
+
+// Paddle and ball dimensions; player paddle sits at left edge, CPU at right edge
+const float PADDLE_WIDTH = 10;
+const float PADDLE_HEIGHT = 60;
+const float PADDLE_PLAYER_X = 5;
+const float PADDLE_CPU_X = GAME_WIDTH - 15;
+const float BALL_SIZE = 10;
+
+// Game logic runs in fixed ticks regardless of display rate
+const int SIM_TICK_RATE = 240;
+const float SIM_DT = 1.0f / SIM_TICK_RATE;
+
+// Most wall/paddle bounces the ball makes within one step; any time left after that is dropped
+const int MATCH_MAX_BOUNCES = 4;
+
+// Direction that ball and paddle can go
+enum Directions {UP = 1, DOWN = -1, ZERO = 0};
+
+// Things that happened during a tick, so the caller can react (eg play score.wav)
+enum MatchEvent {
+    MATCH_EVENT_NONE = 0,
+    MATCH_EVENT_HIT_PLAYER = 1 << 0,
+    MATCH_EVENT_HIT_CPU = 1 << 1,
+    MATCH_EVENT_SCORE_PLAYER = 1 << 2,
+    MATCH_EVENT_SCORE_CPU = 1 << 3
+};
+
+// What drives the right paddle. Only match_step() supports more than CPU_PING_PONG;
+// the batch kernel always plays that.
+enum CpuControl {
+    CPU_PING_PONG = 0,  // Sweeps between the walls at cpu_speed, ignoring the ball
+    CPU_PREDICT,        // Heads at cpu_speed for where the ball will reach it
+    CPU_REMOTE          // Steered through direction_cpu like the player's paddle, eg by netplay
+};
+
+// Levels of CPU_PREDICT, as picked in the options menu
+const int MATCH_CPU_LEVELS = 3;
+
+// Difficulty knobs for a match
+typedef struct MatchConfig {
+    float ball_speed_multiplier;
+    float paddle_speed_multiplier;
+    float cpu_speed;    // CPU paddle speed in px/s before paddle_speed_multiplier
+
+    CpuControl cpu_control;
+    float cpu_reaction; // CPU_PREDICT looks at the ball only this often, in seconds
+    float cpu_error;    // and misjudges where it will arrive by up to this many px
+} MatchConfig;
+
+typedef struct Match {
+    MatchConfig config;
+
+    float position_player_y;
+    float position_cpu_y;
+    float position_ball_x;
+    float position_ball_y;
+
+    // Share of ball speed going along x; the rest goes along y
+    float component_ball_x;
+
+    Directions direction_player;    // Player input for the next tick
+    Directions direction_cpu;       // Chosen by match_step() unless config.cpu_control is CPU_REMOTE
+    Directions direction_ball_x;
+    Directions direction_ball_y;
+
+    int score_player;
+    int score_cpu;
+
+    // CPU_PREDICT's plan: paddle centre it is heading for, and seconds until it looks again
+    float cpu_target_y;
+    float cpu_think_time;
+
+    // State for SDL_rand_r()/SDL_randf_r(), so a match is reproducible from its seed
+    Uint64 rng_state;
+} Match;
+
+// Defaults used by the game before any option is applied (MEDIUM, CPU_PING_PONG)
+void match_default_config(MatchConfig *config);
+
+// Switch 'config' to CPU_PREDICT with the reaction time and error of 'level' (0 to MATCH_CPU_LEVELS-1)
+void match_set_cpu_level(MatchConfig *config, int level);
+
+// Reset 'match' to a fresh 0-0 match using 'seed' for its random serves
+void match_init(Match *match, const MatchConfig *config, Uint64 seed);
+
+// Advance 'match' by 'dt' seconds, returning a mask of MatchEvent
+int match_step(Match *match, float dt);
+
+// Give up on a match that hasn't finished after this long in simulated time
+const float MATCH_PLAY_MAX_SECONDS = 3600;
+
+// What happened over a whole match played by match_play()
+typedef struct MatchSummary {
+    Uint64 ticks;
+    int returns;            // Paddle hits by either side
+    int longest_rally;      // Most paddle hits between two points
+} MatchSummary;
+
+// Play 'match' until one side has 'points' or 'max_ticks' pass, player on autoplay
+void match_play(Match *match, int points, float dt, Uint64 max_ticks, MatchSummary *summary);
+
+// Simple computer control for the player paddle: follow the ball
+Directions match_autoplay_direction(const Match *match);
+
+/* Where the ball's top edge will be when its left edge reaches 'x', in closed form:
+   the straight path is unfolded past the walls and folded back with a modulo, so the
+   cost doesn't depend on how many bounces there are. Paddles are ignored. False if the
+   ball is moving away from 'x'. */
+bool match_ball_intercept_y(const Match *match, float x, float *y);
+
+// Derive a well-mixed seed for match number 'index' from a base seed
+Uint64 match_seed(Uint64 base, Uint64 index);
+
+#endif
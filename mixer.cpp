@@ -0,0 +1,253 @@
+#include "mixer.h"
+#include "adpcm.h"
+#include "trace.h"
+
+static const int MIXER_DEFAULT_FREQ = 48000;
+
+static void start_voice(Mixer *mixer, int sound) {
+    if (sound < 0 || sound >= MIXER_SOUNDS || mixer->sounds[sound].samples == NULL) {
+        return;
+    }
+
+    // Prefer an idle voice, otherwise cut off whichever has been playing longest
+    MixerVoice *chosen = &mixer->voices[0];
+    for (int i = 0; i < MIXER_VOICES; i++) {
+        MixerVoice *voice = &mixer->voices[i];
+        if (voice->sound < 0) {
+            chosen = voice;
+            break;
+        }
+        if (voice->position > chosen->position) {
+            chosen = voice;
+        }
+    }
+    chosen->sound = sound;
+    chosen->position = 0;
+}
+
+/* Runs on the audio device's thread whenever it wants more input: start the voices
+   posted since last time, then mix everything playing. Puts nothing while silent. */
+static void SDLCALL mixer_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount) {
+    trace_thread_name("audio");
+    TRACE_ZONE("mixer");
+    Mixer *mixer = (Mixer *) userdata;
+
+    Uint32 read = mixer->command_read.load(std::memory_order_relaxed);
+    const Uint32 write = mixer->command_write.load(std::memory_order_acquire);
+    for (; read != write; read++) {
+        start_voice(mixer, mixer->commands[read % MIXER_COMMANDS]);
+    }
+    mixer->command_read.store(read, std::memory_order_release);
+
+    const int frame_size = SDL_AUDIO_FRAMESIZE(mixer->spec);
+    int frames = (additional_amount + frame_size - 1) / frame_size;
+    while (frames > 0) {
+        const int chunk = SDL_min(frames, MIXER_CHUNK_FRAMES);
+        SDL_memset(mixer->mix, 0, sizeof(float) * 2 * chunk);
+
+        bool playing = false;
+        for (int i = 0; i < MIXER_VOICES; i++) {
+            MixerVoice *voice = &mixer->voices[i];
+            if (voice->sound < 0) {
+                continue;
+            }
+            const MixerSound *sound = &mixer->sounds[voice->sound];
+            const int count = SDL_min(chunk, sound->frames - voice->position);
+            const Sint16 *in = sound->samples + 2 * voice->position;
+            for (int s = 0; s < 2 * count; s++) {
+                mixer->mix[s] += in[s] * (1.0f / 32768.0f);
+            }
+            voice->position += count;
+            if (voice->position >= sound->frames) {
+                mixer->finished[voice->sound].fetch_add(1, std::memory_order_release);
+                voice->sound = -1;
+            }
+            playing = true;
+        }
+        if (!playing) {
+            break;
+        }
+
+        for (int s = 0; s < 2 * chunk; s++) {
+            mixer->mix[s] = SDL_clamp(mixer->mix[s], -1.0f, 1.0f);
+        }
+        SDL_PutAudioStreamData(stream, mixer->mix, chunk * frame_size);
+        frames -= chunk;
+    }
+}
+
+bool mixer_open(Mixer *mixer, SDL_AudioDeviceID device) {
+    SDL_zeroa(mixer->sounds);
+    for (int i = 0; i < MIXER_VOICES; i++) {
+        mixer->voices[i].sound = -1;
+        mixer->voices[i].position = 0;
+    }
+    mixer->command_read.store(0);
+    mixer->command_write.store(0);
+    mixer->dropped.store(0);
+    for (int i = 0; i < MIXER_SOUNDS; i++) {
+        mixer->finished[i].store(0);
+    }
+
+    // Mix at the device's own rate so SDL has nothing left to convert
+    mixer->spec.format = SDL_AUDIO_F32;
+    mixer->spec.channels = 2;
+    mixer->spec.freq = MIXER_DEFAULT_FREQ;
+    SDL_AudioSpec device_spec;
+    if (device != 0 && SDL_GetAudioDeviceFormat(device, &device_spec, NULL)) {
+        mixer->spec.freq = device_spec.freq;
+    }
+
+    mixer->stream = SDL_CreateAudioStream(&mixer->spec, NULL);
+    if (!mixer->stream || !SDL_SetAudioStreamGetCallback(mixer->stream, mixer_callback, mixer)) {
+        SDL_Log("Couldn't create audio stream: %s", SDL_GetError());
+        return false;
+    }
+    if (device != 0 && !SDL_BindAudioStream(device, mixer->stream)) {
+        SDL_Log("Failed to bind mixer stream to device: %s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+bool mixer_load(Mixer *mixer, int sound, const char *fname) {
+    char *wav_path = NULL;
+    SDL_asprintf(&wav_path, "%s%s", SDL_GetBasePath(), fname);
+    SDL_IOStream *io = SDL_IOFromFile(wav_path, "rb");
+    SDL_free(wav_path);
+    if (!io) {
+        SDL_Log("Couldn't open '%s': %s", fname, SDL_GetError());
+        return false;
+    }
+    return mixer_load_io(mixer, sound, io);
+}
+
+// Format the voices read: 16-bit stereo at the mixer's rate
+static SDL_AudioSpec source_spec(const Mixer *mixer) {
+    SDL_AudioSpec spec = {SDL_AUDIO_S16, 2, mixer->spec.freq};
+    return spec;
+}
+
+static bool valid_slot(int sound) {
+    if (sound < 0 || sound >= MIXER_SOUNDS) {
+        SDL_Log("No sound slot %d", sound);
+        return false;
+    }
+    return true;
+}
+
+// Put 'samples' in slot 'sound', taking ownership of 'owned' if it isn't NULL
+static void set_sound(Mixer *mixer, int sound, const Sint16 *samples, int frames, Sint16 *owned) {
+    SDL_free(mixer->sounds[sound].owned);
+    mixer->sounds[sound].samples = samples;
+    mixer->sounds[sound].frames = frames;
+    mixer->sounds[sound].owned = owned;
+}
+
+// Convert 'len' bytes of 'spec' audio to the voices' format and store it in slot 'sound'
+static bool convert_sound(Mixer *mixer, int sound, const SDL_AudioSpec *spec, const Uint8 *data, int len) {
+    const SDL_AudioSpec target = source_spec(mixer);
+    Uint8 *samples = NULL;
+    int samples_len = 0;
+    if (!SDL_ConvertAudioSamples(spec, data, len, &target, &samples, &samples_len)) {
+        SDL_Log("Couldn't convert sound: %s", SDL_GetError());
+        return false;
+    }
+    set_sound(mixer, sound, (const Sint16 *) samples, samples_len / SDL_AUDIO_FRAMESIZE(target), (Sint16 *) samples);
+    return true;
+}
+
+bool mixer_load_io(Mixer *mixer, int sound, SDL_IOStream *io) {
+    if (!valid_slot(sound)) {
+        SDL_CloseIO(io);
+        return false;
+    }
+
+    SDL_AudioSpec spec;
+    Uint8 *wav_data = NULL;
+    Uint32 wav_data_len = 0;
+    if (!SDL_LoadWAV_IO(io, true, &spec, &wav_data, &wav_data_len)) {
+        SDL_Log("Couldn't load .wav file: %s", SDL_GetError());
+        return false;
+    }
+
+    // Convert once here rather than on every play
+    const bool converted = convert_sound(mixer, sound, &spec, wav_data, (int) wav_data_len);
+    SDL_free(wav_data);
+    return converted;
+}
+
+bool mixer_load_bundle(Mixer *mixer, int sound, const AssetBundle *bundle, const char *name) {
+    const BundleEntry *entry = bundle_find(bundle, name);
+    if (!valid_slot(sound)) {
+        return false;
+    }
+    if (!entry) {
+        SDL_Log("'%s' is not in the asset bundle", name);
+        return false;
+    }
+
+    const SDL_AudioSpec target = source_spec(mixer);
+    const Uint8 *data = bundle_entry_data(bundle, entry);
+    const int frame_size = SDL_AUDIO_FRAMESIZE(bundle->spec);
+    const bool same_format = bundle->spec.freq == target.freq && bundle->spec.channels == target.channels;
+
+    // Packed for this device: play it from the mapping, nothing to load
+    if (entry->codec == BUNDLE_CODEC_S16 && same_format) {
+        set_sound(mixer, sound, (const Sint16 *) data, (int) entry->frames, NULL);
+        return true;
+    }
+    if (entry->codec == BUNDLE_CODEC_S16) {
+        return convert_sound(mixer, sound, &bundle->spec, data, (int) entry->frames * frame_size);
+    }
+
+    // ADPCM: decode the whole effect, then convert if the bundle was packed for another rate
+    const int blocks = (int) ((entry->frames + ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES);
+    Sint16 *decoded = (Sint16 *) SDL_malloc((size_t) blocks * ADPCM_BLOCK_FRAMES * frame_size);
+    if (!decoded) {
+        return false;
+    }
+    for (int i = 0; i < blocks; i++) {
+        adpcm_decode_block(data + (size_t) i * adpcm_block_size(bundle->spec.channels), bundle->spec.channels,
+                           decoded + (size_t) i * ADPCM_BLOCK_FRAMES * bundle->spec.channels);
+    }
+    if (same_format) {
+        set_sound(mixer, sound, decoded, (int) entry->frames, decoded);
+        return true;
+    }
+    const bool converted = convert_sound(mixer, sound, &bundle->spec, (const Uint8 *) decoded, (int) entry->frames * frame_size);
+    SDL_free(decoded);
+    return converted;
+}
+
+void mixer_play(Mixer *mixer, int sound) {
+    const Uint32 write = mixer->command_write.load(std::memory_order_relaxed);
+    const Uint32 read = mixer->command_read.load(std::memory_order_acquire);
+    if (write - read >= (Uint32) MIXER_COMMANDS) {
+        mixer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    mixer->commands[write % MIXER_COMMANDS] = sound;
+    mixer->command_write.store(write + 1, std::memory_order_release);
+}
+
+Uint32 mixer_finished(const Mixer *mixer, int sound) {
+    if (sound < 0 || sound >= MIXER_SOUNDS) {
+        return 0;
+    }
+    return mixer->finished[sound].load(std::memory_order_acquire);
+}
+
+void mixer_close(Mixer *mixer) {
+    // Destroying the stream first guarantees the callback is no longer running
+    if (mixer->stream) {
+        SDL_DestroyAudioStream(mixer->stream);
+        mixer->stream = NULL;
+    }
+    if (mixer->dropped.load() > 0) {
+        SDL_Log("Mixer dropped %d sounds with its command queue full", mixer->dropped.load());
+    }
+    for (int i = 0; i < MIXER_SOUNDS; i++) {
+        set_sound(mixer, i, NULL, 0, NULL);
+    }
+}
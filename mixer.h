@@ -0,0 +1,71 @@
+/* Sound effects mixer: every effect is decoded once, converted to the device's rate, and
+ * played by one of a fixed pool of voices mixed into a single stream. Effects from an
+ * asset bundle packed at that rate are played straight from the mapped file.
+ * mixer_play() only posts a command to a lock-free queue; the audio device's thread picks
+ * it up, so triggering a sound never allocates, locks or copies sample data on the game
+ * thread.
+ */
+
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include "bundle.h"
+
+const int MIXER_SOUNDS = 8;         // Effects that can be loaded
+const int MIXER_VOICES = 8;         // Effects that can play at once
+const int MIXER_COMMANDS = 32;      // Plays that can be waiting for the audio thread; power of two
+const int MIXER_CHUNK_FRAMES = 512; // Frames mixed per pass of the callback
+
+typedef struct MixerSound {
+    const Sint16 *samples;  // Interleaved stereo at the mixer's rate
+    int frames;
+    Sint16 *owned;          // 'samples' if they were converted here rather than mapped
+} MixerSound;
+
+typedef struct MixerVoice {
+    int sound;          // -1 when idle
+    int position;       // Next frame to play
+} MixerVoice;
+
+typedef struct Mixer {
+    SDL_AudioStream *stream;
+    SDL_AudioSpec spec;                 // F32 stereo at the device's rate
+    MixerSound sounds[MIXER_SOUNDS];    // Read-only once loaded
+
+    // Single producer (mixer_play()), single consumer (the audio callback); free-running indices
+    int commands[MIXER_COMMANDS];
+    std::atomic<Uint32> command_read;
+    std::atomic<Uint32> command_write;
+    std::atomic<int> dropped;           // Plays lost because the queue was full
+    std::atomic<Uint32> finished[MIXER_SOUNDS];  // Plays of each sound mixed to their last frame
+
+    // Only touched by the audio callback
+    MixerVoice voices[MIXER_VOICES];
+    float mix[MIXER_CHUNK_FRAMES * 2];
+} Mixer;
+
+/* Create the mixer's stream and bind it to 'device'. With 'device' 0 the stream is left
+   unbound, at 48 kHz, for the caller to pull from. */
+bool mixer_open(Mixer *mixer, SDL_AudioDeviceID device);
+
+// Load the .wav 'fname' from next to the executable into slot 'sound'; do this before playing
+bool mixer_load(Mixer *mixer, int sound, const char *fname);
+
+// Same from 'io', which is closed afterwards
+bool mixer_load_io(Mixer *mixer, int sound, SDL_IOStream *io);
+
+// Same from the bundle entry 'name'; the bundle must stay open until mixer_close()
+bool mixer_load_bundle(Mixer *mixer, int sound, const AssetBundle *bundle, const char *name);
+
+// Start 'sound' on a free voice (or the one that has played longest); safe from the game thread
+void mixer_play(Mixer *mixer, int sound);
+
+/* How many plays of 'sound' have been mixed to the end, for cues synced to a sound. The
+   last frames are then in the device's buffer, to be heard within its latency. */
+Uint32 mixer_finished(const Mixer *mixer, int sound);
+
+void mixer_close(Mixer *mixer);
+
+#endif
@@ -0,0 +1,294 @@
+#include "music.h"
+#include "trace.h"
+
+static const Uint16 WAVE_FORMAT_PCM = 0x0001;
+static const Uint16 WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+static const Uint16 WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+static Uint32 fourcc(const char *tag) {
+    return (Uint32) tag[0] | ((Uint32) tag[1] << 8) | ((Uint32) tag[2] << 16) | ((Uint32) tag[3] << 24);
+}
+
+// Map a WAV format tag and sample width to an SDL audio format, or 0 if unsupported
+static SDL_AudioFormat wav_audio_format(Uint16 tag, Uint16 bits) {
+    if (tag == WAVE_FORMAT_PCM) {
+        switch (bits) {
+            case 8: return SDL_AUDIO_U8;
+            case 16: return SDL_AUDIO_S16LE;
+            case 32: return SDL_AUDIO_S32LE;
+        }
+    } else if (tag == WAVE_FORMAT_IEEE_FLOAT && bits == 32) {
+        return SDL_AUDIO_F32LE;
+    }
+    return SDL_AUDIO_UNKNOWN;
+}
+
+// Walk the RIFF chunks for the format and the position of the samples
+static bool parse_wav(MusicStream *music) {
+    SDL_IOStream *io = music->io;
+    Uint32 riff, riff_size, wave;
+    if (!SDL_ReadU32LE(io, &riff) || !SDL_ReadU32LE(io, &riff_size) || !SDL_ReadU32LE(io, &wave) ||
+        riff != fourcc("RIFF") || wave != fourcc("WAVE")) {
+        SDL_SetError("Not a RIFF/WAVE file");
+        return false;
+    }
+
+    SDL_AudioFormat format = SDL_AUDIO_UNKNOWN;
+    Uint16 channels = 0;
+    Uint32 rate = 0;
+    for (;;) {
+        Uint32 id, size;
+        if (!SDL_ReadU32LE(io, &id) || !SDL_ReadU32LE(io, &size)) {
+            SDL_SetError("No data chunk");
+            return false;
+        }
+        const Sint64 chunk_start = SDL_TellIO(io);
+
+        if (id == fourcc("fmt ")) {
+            Uint16 tag, block_align, bits;
+            Uint32 byte_rate;
+            if (size < 16 || !SDL_ReadU16LE(io, &tag) || !SDL_ReadU16LE(io, &channels) || !SDL_ReadU32LE(io, &rate) ||
+                !SDL_ReadU32LE(io, &byte_rate) || !SDL_ReadU16LE(io, &block_align) || !SDL_ReadU16LE(io, &bits)) {
+                SDL_SetError("Truncated fmt chunk");
+                return false;
+            }
+            // The real format tag of an extensible header is the start of its sub-format GUID
+            Uint16 cb_size, valid_bits;
+            Uint32 channel_mask;
+            if (tag == WAVE_FORMAT_EXTENSIBLE && size >= 40 && SDL_ReadU16LE(io, &cb_size) &&
+                SDL_ReadU16LE(io, &valid_bits) && SDL_ReadU32LE(io, &channel_mask)) {
+                SDL_ReadU16LE(io, &tag);
+            }
+            format = wav_audio_format(tag, bits);
+            if (format == SDL_AUDIO_UNKNOWN || channels == 0 || rate == 0) {
+                SDL_SetError("Unsupported WAV format %u, %u bits; only PCM and float can be streamed", tag, bits);
+                return false;
+            }
+        } else if (id == fourcc("data")) {
+            if (format == SDL_AUDIO_UNKNOWN) {
+                SDL_SetError("data chunk before fmt chunk");
+                return false;
+            }
+            music->spec.format = format;
+            music->spec.channels = channels;
+            music->spec.freq = (int) rate;
+            music->frame_size = SDL_AUDIO_FRAMESIZE(music->spec);
+            music->data_start = chunk_start;
+            music->data_size = size - size % music->frame_size;
+            if (music->data_size == 0) {
+                SDL_SetError("No samples");
+                return false;
+            }
+            return true;
+        }
+
+        // Chunks are padded to an even size
+        if (SDL_SeekIO(io, chunk_start + size + (size & 1), SDL_IO_SEEK_SET) < 0) {
+            return false;
+        }
+    }
+}
+
+/* Runs on the audio device's thread whenever it wants more input. Only copies out of
+   the ring; the disk is never touched from here. */
+static void SDLCALL music_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount) {
+    trace_thread_name("audio");
+    TRACE_ZONE("BGM SDL_PutAudioStreamData");
+    MusicStream *music = (MusicStream *) userdata;
+    const Uint32 capacity = music->ring_capacity;
+    const Uint32 read = music->ring_read.load(std::memory_order_relaxed);
+    const Uint32 write = music->ring_write.load(std::memory_order_acquire);
+    const Uint32 available = (write + capacity - read) % capacity;
+    if (additional_amount <= 0) {
+        return;
+    }
+
+    Uint32 wanted = (Uint32) additional_amount;
+    wanted += (music->frame_size - wanted % music->frame_size) % music->frame_size;
+    if (wanted > available) {
+        // Before the first music_update() silence is expected, not a dropout
+        if (music->playing.load(std::memory_order_relaxed)) {
+            music->underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        wanted = available;
+    }
+
+    const Uint32 first = SDL_min(wanted, capacity - read);
+    SDL_PutAudioStreamData(stream, music->ring + read, (int) first);
+    if (wanted > first) {
+        SDL_PutAudioStreamData(stream, music->ring, (int) (wanted - first));
+    }
+    music->ring_read.store((read + wanted) % capacity, std::memory_order_release);
+}
+
+bool music_open(MusicStream *music, const char *fname, SDL_AudioDeviceID device, int buffer_ms) {
+    char *wav_path = NULL;
+    SDL_asprintf(&wav_path, "%s%s", SDL_GetBasePath(), fname);
+    SDL_IOStream *io = SDL_IOFromFile(wav_path, "rb");
+    SDL_free(wav_path);
+    if (!io) {
+        SDL_Log("Couldn't open '%s': %s", fname, SDL_GetError());
+        return false;
+    }
+    return music_open_io(music, io, device, buffer_ms);
+}
+
+static void reset(MusicStream *music, SDL_IOStream *io) {
+    music->stream = NULL;
+    music->io = io;
+    music->adpcm = NULL;
+    music->decoded_size = 0;
+    music->decoded_position = 0;
+    music->ring = NULL;
+    music->ring_read.store(0);
+    music->ring_write.store(0);
+    music->underruns.store(0);
+    music->playing.store(false);
+    music->data_start = 0;
+    music->data_position = 0;
+}
+
+// Allocate the ring and create the stream once the source and its format are known
+static bool start(MusicStream *music, SDL_AudioDeviceID device, int buffer_ms) {
+    // One frame of the ring always stays empty, so add it on top of the requested depth
+    const Uint32 frames = (Uint32) SDL_max(1, (Sint64) music->spec.freq * buffer_ms / 1000);
+    music->ring_capacity = (frames + 1) * music->frame_size;
+    music->ring = (Uint8 *) SDL_malloc(music->ring_capacity);
+    if (!music->ring) {
+        music_close(music);
+        return false;
+    }
+    music->stream = SDL_CreateAudioStream(&music->spec, NULL);
+    if (!music->stream || !SDL_SetAudioStreamGetCallback(music->stream, music_callback, music)) {
+        SDL_Log("Couldn't create audio stream: %s", SDL_GetError());
+        music_close(music);
+        return false;
+    }
+    if (device != 0 && !SDL_BindAudioStream(device, music->stream)) {
+        SDL_Log("Failed to bind music stream to device: %s", SDL_GetError());
+        music_close(music);
+        return false;
+    }
+    return true;
+}
+
+bool music_open_io(MusicStream *music, SDL_IOStream *io, SDL_AudioDeviceID device, int buffer_ms) {
+    reset(music, io);
+    if (!parse_wav(music) || SDL_SeekIO(io, music->data_start, SDL_IO_SEEK_SET) < 0) {
+        SDL_Log("Couldn't stream music: %s", SDL_GetError());
+        music_close(music);
+        return false;
+    }
+    return start(music, device, buffer_ms);
+}
+
+bool music_open_bundle(MusicStream *music, const AssetBundle *bundle, const char *name, SDL_AudioDeviceID device, int buffer_ms) {
+    reset(music, NULL);
+    const BundleEntry *entry = bundle_find(bundle, name);
+    if (!entry || entry->frames == 0 || bundle->spec.channels > MUSIC_MAX_CHANNELS) {
+        SDL_Log("No playable '%s' in the asset bundle", name);
+        return false;
+    }
+
+    // The stream converts from the bundle's rate if the device wants another
+    music->spec = bundle->spec;
+    music->frame_size = SDL_AUDIO_FRAMESIZE(music->spec);
+    music->data_size = entry->frames * music->frame_size;
+    const Uint8 *data = bundle_entry_data(bundle, entry);
+    if (entry->codec == BUNDLE_CODEC_ADPCM) {
+        music->adpcm = data;
+    } else {
+        music->io = SDL_IOFromConstMem(data, music->data_size);
+        if (!music->io) {
+            SDL_Log("Couldn't stream music: %s", SDL_GetError());
+            return false;
+        }
+    }
+    return start(music, device, buffer_ms);
+}
+
+// Stop reading after an error; the ring plays out and then the music goes quiet
+static void stop_source(MusicStream *music, const char *what) {
+    SDL_Log("Music stopped, couldn't %s: %s", what, SDL_GetError());
+    if (music->io) {
+        SDL_CloseIO(music->io);
+        music->io = NULL;
+    }
+    music->adpcm = NULL;
+}
+
+// Copy up to 'span' bytes of the next samples to 'out'; returns how many, 0 on error
+static Uint32 read_samples(MusicStream *music, Uint8 *out, Uint32 span) {
+    span = SDL_min(span, music->data_size - music->data_position);
+    if (music->adpcm) {
+        if (music->decoded_position == music->decoded_size) {
+            const Uint32 decoded_block_size = ADPCM_BLOCK_FRAMES * music->frame_size;
+            const Uint32 block = music->data_position / decoded_block_size;
+            adpcm_decode_block(music->adpcm + (size_t) block * adpcm_block_size(music->spec.channels),
+                               music->spec.channels, music->decoded);
+            music->decoded_size = decoded_block_size;
+            music->decoded_position = 0;
+        }
+        span = SDL_min(span, music->decoded_size - music->decoded_position);
+        SDL_memcpy(out, (const Uint8 *) music->decoded + music->decoded_position, span);
+        music->decoded_position += span;
+        return span;
+    }
+    if (SDL_ReadIO(music->io, out, span) != span) {
+        stop_source(music, "read");
+        return 0;
+    }
+    return span;
+}
+
+void music_update(MusicStream *music) {
+    if (!music->io && !music->adpcm) {
+        return;
+    }
+    TRACE_ZONE("BGM refill");
+    const Uint32 capacity = music->ring_capacity;
+    const Uint32 read = music->ring_read.load(std::memory_order_acquire);
+    Uint32 write = music->ring_write.load(std::memory_order_relaxed);
+    Uint32 space = capacity - music->frame_size - (write + capacity - read) % capacity;
+
+    while (space > 0) {
+        // Largest piece that is contiguous both in the ring and in the source
+        const Uint32 span = read_samples(music, music->ring + write, SDL_min(space, capacity - write));
+        if (span == 0) {
+            break;
+        }
+
+        write = (write + span) % capacity;
+        space -= span;
+        music->data_position += span;
+        if (music->data_position == music->data_size) {
+            // Loop: the first samples follow the last ones directly in the ring, so no gap
+            music->data_position = 0;
+            music->decoded_size = 0;
+            music->decoded_position = 0;
+            if (music->io && SDL_SeekIO(music->io, music->data_start, SDL_IO_SEEK_SET) < 0) {
+                stop_source(music, "loop");
+                break;
+            }
+        }
+    }
+    music->ring_write.store(write, std::memory_order_release);
+    music->playing.store(true, std::memory_order_relaxed);
+}
+
+void music_close(MusicStream *music) {
+    // Destroying the stream first guarantees the callback is no longer reading the ring
+    if (music->stream) {
+        SDL_DestroyAudioStream(music->stream);
+        music->stream = NULL;
+    }
+    if (music->underruns.load() > 0) {
+        SDL_Log("Music ran dry %d times; a larger --music-buffer-ms may help", music->underruns.load());
+    }
+    if (music->io) {
+        SDL_CloseIO(music->io);
+        music->io = NULL;
+    }
+    SDL_free(music->ring);
+    music->ring = NULL;
+}
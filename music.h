@@ -0,0 +1,63 @@
+/* Background music streamed from disk. The main thread reads the WAV (or an asset bundle
+ * entry, decoding ADPCM a block at a time) in small pieces into a fixed-size ring buffer,
+ * looping back to the start of its samples without a gap; the audio device's thread
+ * pulls from the ring as it needs data. Only the ring (a few hundred milliseconds of
+ * audio) is ever in memory.
+ */
+
+#ifndef MUSIC_H
+#define MUSIC_H
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include "adpcm.h"
+#include "bundle.h"
+
+const int MUSIC_DEFAULT_BUFFER_MS = 250;
+const int MUSIC_MAX_CHANNELS = 2;       // Of ADPCM bundle entries
+
+typedef struct MusicStream {
+    SDL_AudioStream *stream;
+    SDL_IOStream *io;           // Source of a .wav or an uncompressed bundle entry
+    SDL_AudioSpec spec;
+    int frame_size;
+
+    // PCM samples inside the file
+    Sint64 data_start;
+    Uint32 data_size;
+    Uint32 data_position;   // Next byte to read, relative to data_start
+
+    // Source of an ADPCM bundle entry, decoded one block at a time
+    const Uint8 *adpcm;
+    Sint16 decoded[ADPCM_BLOCK_FRAMES * MUSIC_MAX_CHANNELS];
+    Uint32 decoded_size;
+    Uint32 decoded_position;
+
+    /* Single producer (music_update()) and single consumer (the audio callback).
+       Positions are byte offsets into 'ring'; one frame is always left empty so that
+       read == write means empty. */
+    Uint8 *ring;
+    Uint32 ring_capacity;
+    std::atomic<Uint32> ring_read;
+    std::atomic<Uint32> ring_write;
+
+    std::atomic<bool> playing;      // Set by the first music_update(); silent until then
+    std::atomic<int> underruns;     // Times the device asked for more than the ring held
+} MusicStream;
+
+// Open the .wav 'fname' from next to the executable and play it through 'device', looping
+bool music_open(MusicStream *music, const char *fname, SDL_AudioDeviceID device, int buffer_ms);
+
+/* Same from 'io', which the music then owns. With 'device' 0 the stream is left unbound
+   for the caller to pull from. */
+bool music_open_io(MusicStream *music, SDL_IOStream *io, SDL_AudioDeviceID device, int buffer_ms);
+
+// Same from the bundle entry 'name'; the bundle must stay open until music_close()
+bool music_open_bundle(MusicStream *music, const AssetBundle *bundle, const char *name, SDL_AudioDeviceID device, int buffer_ms);
+
+// Top the ring buffer up from disk; call once a frame while the music should play
+void music_update(MusicStream *music);
+
+void music_close(MusicStream *music);
+
+#endif
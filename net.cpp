@@ -0,0 +1,452 @@
+#include "net.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+typedef SOCKET NativeSocket;
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int NativeSocket;
+#endif
+
+static const Sint64 NET_NO_SOCKET = -1;
+
+static void close_socket(Sint64 socket) {
+#ifdef _WIN32
+    closesocket((NativeSocket) socket);
+#else
+    close((NativeSocket) socket);
+#endif
+}
+
+static void reset_session(NetSession *net, const NetConditions *conditions) {
+    SDL_zerop(net);
+    net->socket = NET_NO_SOCKET;
+    net->rollback_from = NET_NO_ROLLBACK;
+    net->checked_tick = NET_NO_ROLLBACK;
+    net->remote_checksum_tick = NET_NO_ROLLBACK;
+    if (conditions) {
+        net->conditions = *conditions;
+    }
+    net->rng_state = SDL_GetPerformanceCounter();
+}
+
+// Non-blocking UDP socket bound to 'port' (0 for any)
+static bool open_socket(NetSession *net, Uint16 port) {
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        SDL_Log("Couldn't start Winsock");
+        return false;
+    }
+#endif
+    const Sint64 s = (Sint64) socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+    if ((SOCKET) s == INVALID_SOCKET) {
+#else
+    if (s < 0) {
+#endif
+        SDL_Log("Couldn't create socket");
+        return false;
+    }
+
+    struct sockaddr_in address;
+    SDL_zero(address);
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind((NativeSocket) s, (struct sockaddr *) &address, sizeof(address)) != 0) {
+        SDL_Log("Couldn't bind UDP port %d", (int) port);
+        close_socket(s);
+        return false;
+    }
+
+#ifdef _WIN32
+    u_long non_blocking = 1;
+    ioctlsocket((SOCKET) s, FIONBIO, &non_blocking);
+#else
+    fcntl((NativeSocket) s, F_SETFL, fcntl((NativeSocket) s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    net->socket = s;
+    return true;
+}
+
+static void put_u32(Uint8 *p, Uint32 value) {
+    p[0] = (Uint8) value;
+    p[1] = (Uint8) (value >> 8);
+    p[2] = (Uint8) (value >> 16);
+    p[3] = (Uint8) (value >> 24);
+}
+
+static Uint32 get_u32(const Uint8 *p) {
+    return (Uint32) p[0] | ((Uint32) p[1] << 8) | ((Uint32) p[2] << 16) | ((Uint32) p[3] << 24);
+}
+
+static void put_u64(Uint8 *p, Uint64 value) {
+    put_u32(p, (Uint32) value);
+    put_u32(p + 4, (Uint32) (value >> 32));
+}
+
+static Uint64 get_u64(const Uint8 *p) {
+    return (Uint64) get_u32(p) | ((Uint64) get_u32(p + 4) << 32);
+}
+
+static void put_float(Uint8 *p, float value) {
+    Uint32 bits;
+    SDL_memcpy(&bits, &value, sizeof(bits));
+    put_u32(p, bits);
+}
+
+static float get_float(const Uint8 *p) {
+    const Uint32 bits = get_u32(p);
+    float value;
+    SDL_memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void send_now(NetSession *net, const Uint8 *data, int size) {
+    sendto((NativeSocket) net->socket, (const char *) data, size, 0,
+           (const struct sockaddr *) net->peer_address, (socklen_t) net->peer_address_len);
+}
+
+// Send through the artificial conditions: maybe drop it, maybe hold it back for a while
+static void send_packet(NetSession *net, const Uint8 *data, int size) {
+    if (net->peer_address_len == 0) {
+        return;
+    }
+    if (net->conditions.loss > 0 && SDL_randf_r(&net->rng_state) < net->conditions.loss) {
+        return;
+    }
+    if (net->conditions.delay_ms <= 0 || net->delayed_count == NET_DELAY_QUEUE) {
+        send_now(net, data, size);
+        return;
+    }
+    DelayedPacket *packet = &net->delayed[(net->delayed_first + net->delayed_count) % NET_DELAY_QUEUE];
+    packet->send_ns = SDL_GetTicksNS() + (Uint64) net->conditions.delay_ms * SDL_NS_PER_MS;
+    packet->size = size;
+    SDL_memcpy(packet->data, data, size);
+    net->delayed_count++;
+}
+
+static Uint64 fnv_mix(Uint64 hash, Uint32 value) {
+    for (int i = 0; i < 4; i++) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static Uint32 float_bits(float value) {
+    Uint32 bits;
+    SDL_memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Everything that evolves during a match, so both peers can tell they still agree
+static Uint64 match_checksum(const Match *match) {
+    Uint64 hash = 0xCBF29CE484222325ULL;
+    hash = fnv_mix(hash, float_bits(match->position_player_y));
+    hash = fnv_mix(hash, float_bits(match->position_cpu_y));
+    hash = fnv_mix(hash, float_bits(match->position_ball_x));
+    hash = fnv_mix(hash, float_bits(match->position_ball_y));
+    hash = fnv_mix(hash, float_bits(match->component_ball_x));
+    hash = fnv_mix(hash, (Uint32) match->direction_ball_x);
+    hash = fnv_mix(hash, (Uint32) match->direction_ball_y);
+    hash = fnv_mix(hash, (Uint32) match->score_player);
+    hash = fnv_mix(hash, (Uint32) match->score_cpu);
+    hash = fnv_mix(hash, (Uint32) match->rng_state);
+    hash = fnv_mix(hash, (Uint32) (match->rng_state >> 32));
+    return hash;
+}
+
+static void start_match(NetSession *net, Match *match) {
+    MatchConfig config = net->config;
+    config.cpu_control = CPU_REMOTE;
+    match_init(match, &config, net->seed);
+    net->snapshots[0] = *match;
+    net->started = true;
+    SDL_Log("Netplay match started as %s, seed %" SDL_PRIu64, net->host ? "host" : "client", net->seed);
+}
+
+static void send_start(NetSession *net) {
+    Uint8 packet[17];
+    packet[0] = 'S';
+    put_u64(packet + 1, net->seed);
+    put_float(packet + 9, net->config.ball_speed_multiplier);
+    put_float(packet + 13, net->config.paddle_speed_multiplier);
+    send_packet(net, packet, sizeof(packet));
+}
+
+// What the peer is assumed to press on a tick whose input hasn't arrived: whatever it last pressed
+static Sint8 predicted_input(const NetSession *net) {
+    return net->remote_confirmed == 0 ? 0 : net->remote_inputs[(net->remote_confirmed - 1) % NET_HISTORY];
+}
+
+// Run tick 'tick' from the recorded inputs, predicting the peer's where they aren't confirmed
+static int step_tick(NetSession *net, Match *match, Uint32 tick) {
+    const int slot = tick % NET_HISTORY;
+    if (tick >= net->remote_confirmed) {
+        net->remote_inputs[slot] = predicted_input(net);
+    }
+    const Directions local = (Directions) net->local_inputs[slot];
+    const Directions remote = (Directions) net->remote_inputs[slot];
+    match->direction_player = net->host ? local : remote;
+    match->direction_cpu = net->host ? remote : local;
+    const int events = match_step(match, SIM_DT);
+    net->snapshots[(tick + 1) % NET_HISTORY] = *match;
+    return events;
+}
+
+static void receive_inputs(NetSession *net, const Uint8 *packet, int size) {
+    if (size < 6) {
+        return;
+    }
+    const Uint32 first = get_u32(packet + 1);
+    const int count = packet[5];
+    if (size < 6 + count + 16) {
+        return;
+    }
+    const Uint8 *tail = packet + 6 + count;
+
+    // Only take them in order; anything missing is sent again with the next packet
+    for (int i = 0; i < count; i++) {
+        const Uint32 tick = first + (Uint32) i;
+        if (tick != net->remote_confirmed) {
+            continue;
+        }
+        const Sint8 input = (Sint8) packet[6 + i];
+        const int slot = tick % NET_HISTORY;
+        if (tick < net->tick && net->remote_inputs[slot] != input && tick < net->rollback_from) {
+            net->rollback_from = tick;
+        }
+        net->remote_inputs[slot] = input;
+        net->remote_confirmed++;
+    }
+
+    const Uint32 ack = get_u32(tail);
+    if (ack > net->local_acked && ack <= net->tick) {
+        net->local_acked = ack;
+    }
+    const Uint32 checksum_tick = get_u32(tail + 4);
+    if (checksum_tick != NET_NO_ROLLBACK &&
+            (net->remote_checksum_tick == NET_NO_ROLLBACK || checksum_tick > net->remote_checksum_tick)) {
+        net->remote_checksum_tick = checksum_tick;
+        net->remote_checksum = get_u64(tail + 8);
+    }
+}
+
+// Replay every tick from the first mispredicted one with the inputs as now known
+static void roll_back(NetSession *net, Match *match) {
+    const Uint32 from = net->rollback_from;
+    net->rollback_from = NET_NO_ROLLBACK;
+    *match = net->snapshots[from % NET_HISTORY];
+    for (Uint32 tick = from; tick < net->tick; tick++) {
+        step_tick(net, match, tick);
+    }
+    net->rollbacks++;
+    net->resimulated_ticks += net->tick - from;
+    net->longest_rollback = SDL_max(net->longest_rollback, net->tick - from);
+}
+
+// Latest tick whose state depends only on confirmed inputs and is still in the history
+static Uint32 confirmed_tick(const NetSession *net) {
+    return SDL_min(net->remote_confirmed, net->tick);
+}
+
+static void check_desync(NetSession *net) {
+    const Uint32 tick = net->remote_checksum_tick;
+    if (tick == NET_NO_ROLLBACK || tick == net->checked_tick ||
+            tick > confirmed_tick(net) || net->tick - tick >= (Uint32) NET_HISTORY) {
+        return;
+    }
+    net->checked_tick = tick;
+    if (match_checksum(&net->snapshots[tick % NET_HISTORY]) != net->remote_checksum) {
+        SDL_Log("Netplay desync at tick %u", tick);
+        net->desyncs++;
+    }
+}
+
+bool net_host(NetSession *net, Uint16 port, Uint64 seed, const MatchConfig *config, const NetConditions *conditions) {
+    reset_session(net, conditions);
+    net->host = true;
+    net->seed = seed;
+    net->config = *config;
+    if (!open_socket(net, port)) {
+        return false;
+    }
+    SDL_Log("Waiting for a client on UDP port %d", (int) port);
+    return true;
+}
+
+bool net_connect(NetSession *net, const char *address, const NetConditions *conditions) {
+    reset_session(net, conditions);
+
+    char host[256];
+    SDL_strlcpy(host, address, sizeof(host));
+    char *colon = SDL_strrchr(host, ':');
+    if (colon == NULL) {
+        SDL_Log("Expected HOST:PORT, got '%s'", address);
+        return false;
+    }
+    *colon = '\0';
+    const char *port = colon + 1;
+
+    if (!open_socket(net, 0)) {
+        return false;
+    }
+
+    struct addrinfo hints;
+    SDL_zero(hints);
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    struct addrinfo *result = NULL;
+    if (getaddrinfo(host, port, &hints, &result) != 0 || result == NULL) {
+        SDL_Log("Couldn't resolve '%s'", address);
+        net_close(net);
+        return false;
+    }
+    SDL_memcpy(net->peer_address, result->ai_addr, result->ai_addrlen);
+    net->peer_address_len = (int) result->ai_addrlen;
+    freeaddrinfo(result);
+    SDL_Log("Connecting to %s", address);
+    return true;
+}
+
+bool net_poll(NetSession *net, Match *match) {
+    bool replaced = false;
+    Uint8 packet[NET_MAX_PACKET];
+    for (;;) {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        const int size = (int) recvfrom((NativeSocket) net->socket, (char *) packet, sizeof(packet), 0,
+                                        (struct sockaddr *) &from, &from_len);
+        if (size <= 0) {
+            break;
+        }
+
+        // The host takes its peer from the first hello; after that, only that peer counts
+        if (net->peer_address_len == 0 && net->host && packet[0] == 'H') {
+            SDL_memcpy(net->peer_address, &from, sizeof(from));
+            net->peer_address_len = (int) sizeof(from);
+        }
+        if (net->peer_address_len != (int) from_len || SDL_memcmp(net->peer_address, &from, from_len) != 0) {
+            continue;
+        }
+
+        if (packet[0] == 'H' && net->host) {
+            // Sent again for every hello in case the start was lost
+            send_start(net);
+            if (!net->started) {
+                start_match(net, match);
+                replaced = true;
+            }
+        } else if (packet[0] == 'S' && !net->host && size >= 17) {
+            if (!net->started) {
+                match_default_config(&net->config);
+                net->seed = get_u64(packet + 1);
+                net->config.ball_speed_multiplier = get_float(packet + 9);
+                net->config.paddle_speed_multiplier = get_float(packet + 13);
+                start_match(net, match);
+                replaced = true;
+            }
+        } else if (packet[0] == 'I' && net->started) {
+            receive_inputs(net, packet, size);
+        }
+    }
+
+    if (net->rollback_from != NET_NO_ROLLBACK) {
+        roll_back(net, match);
+        replaced = true;
+    }
+    if (net->started) {
+        check_desync(net);
+    }
+    return replaced;
+}
+
+int net_advance(NetSession *net, Match *match, Directions local) {
+    if (!net->started) {
+        return -1;
+    }
+    // Too far ahead of what we know of the peer; rolling back any further would get costly
+    if (net->tick >= net->remote_confirmed + NET_MAX_PREDICTION) {
+        net->stalls++;
+        return -1;
+    }
+    net->local_inputs[net->tick % NET_HISTORY] = (Sint8) local;
+    const int events = step_tick(net, match, net->tick);
+    net->tick++;
+    return events;
+}
+
+void net_flush(NetSession *net) {
+    if (net->socket == NET_NO_SOCKET) {
+        return;
+    }
+
+    if (!net->started && !net->host) {
+        const Uint8 hello = 'H';
+        send_packet(net, &hello, 1);
+    } else if (net->started) {
+        /* Every input the peer hasn't acknowledged, so a lost packet costs nothing but a
+           little lateness. The peer never runs more than NET_MAX_PREDICTION ticks past the
+           inputs it has from us, nor we past its, so it has everything older than this. */
+        Uint32 first = net->local_acked;
+        if (net->tick > 2 * NET_MAX_PREDICTION) {
+            first = SDL_max(first, net->tick - 2 * NET_MAX_PREDICTION);
+        }
+        const int count = (int) (net->tick - first);
+
+        Uint8 packet[NET_MAX_PACKET];
+        packet[0] = 'I';
+        put_u32(packet + 1, first);
+        packet[5] = (Uint8) count;
+        for (int i = 0; i < count; i++) {
+            packet[6 + i] = (Uint8) net->local_inputs[(first + i) % NET_HISTORY];
+        }
+        Uint8 *tail = packet + 6 + count;
+        put_u32(tail, net->remote_confirmed);
+
+        const Uint32 checksum_tick = confirmed_tick(net) / NET_CHECKSUM_INTERVAL * NET_CHECKSUM_INTERVAL;
+        if (checksum_tick > 0 && net->tick - checksum_tick < (Uint32) NET_HISTORY) {
+            put_u32(tail + 4, checksum_tick);
+            put_u64(tail + 8, match_checksum(&net->snapshots[checksum_tick % NET_HISTORY]));
+        } else {
+            put_u32(tail + 4, NET_NO_ROLLBACK);
+            put_u64(tail + 8, 0);
+        }
+        send_packet(net, packet, 6 + count + 16);
+    }
+
+    // Let out whatever has been held back long enough
+    const Uint64 now = SDL_GetTicksNS();
+    while (net->delayed_count > 0 && net->delayed[net->delayed_first].send_ns <= now) {
+        const DelayedPacket *packet = &net->delayed[net->delayed_first];
+        send_now(net, packet->data, packet->size);
+        net->delayed_first = (net->delayed_first + 1) % NET_DELAY_QUEUE;
+        net->delayed_count--;
+    }
+}
+
+void net_close(NetSession *net) {
+    if (net->socket == NET_NO_SOCKET) {
+        return;
+    }
+    if (net->started) {
+        SDL_Log("Netplay: %u ticks, %d rollbacks re-simulating %" SDL_PRIu64 " ticks (longest %u), "
+                "%d stalled frames, %d desyncs",
+                net->tick, net->rollbacks, net->resimulated_ticks, net->longest_rollback, net->stalls, net->desyncs);
+    }
+    close_socket(net->socket);
+    net->socket = NET_NO_SOCKET;
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
@@ -0,0 +1,105 @@
+/* Two-player netplay over UDP with rollback. Only inputs cross the network: each peer
+ * simulates the match itself, predicting the remote paddle's input as whatever it last
+ * was. When the real input arrives and differs, the match is restored from the snapshot
+ * taken before that tick and re-simulated up to the present. A Match is plain data, so a
+ * snapshot is a struct copy and re-simulating a few dozen ticks costs microseconds.
+ *
+ * The host steers the left paddle and picks the seed and difficulty; the client steers
+ * the right one. Packets (little-endian, one per frame):
+ *   'H'  hello       client -> host until the match starts
+ *   'S'  start       U64 seed, F32 ball speed, F32 paddle speed
+ *   'I'  inputs      U32 first tick, U8 count, S8 direction[count], U32 ack,
+ *                    U32 checksum tick, U64 checksum
+ */
+
+#ifndef NET_H
+#define NET_H
+
+#include <SDL3/SDL.h>
+#include "match.h"
+
+// Ticks of snapshots and inputs kept; power of two, more than twice NET_MAX_PREDICTION
+const int NET_HISTORY = 256;
+
+// Furthest the simulation runs ahead of the last input received from the peer before it waits
+const Uint32 NET_MAX_PREDICTION = 60;
+
+// Confirmed states are compared between the peers every this many ticks
+const Uint32 NET_CHECKSUM_INTERVAL = 60;
+
+// Artificial conditions applied to outgoing packets, for testing over loopback
+typedef struct NetConditions {
+    int delay_ms;
+    float loss;         // Fraction of packets dropped, 0 to 1
+} NetConditions;
+
+const int NET_MAX_PACKET = 320;
+const int NET_DELAY_QUEUE = 256;
+
+typedef struct DelayedPacket {
+    Uint64 send_ns;
+    int size;
+    Uint8 data[NET_MAX_PACKET];
+} DelayedPacket;
+
+typedef struct NetSession {
+    Sint64 socket;
+    Uint8 peer_address[32];     // sockaddr of the peer, once known
+    int peer_address_len;
+    bool host;
+    bool started;
+
+    // What the host sends in its start packet
+    Uint64 seed;
+    MatchConfig config;
+
+    Uint32 tick;                            // Next tick to simulate
+    Sint8 local_inputs[NET_HISTORY];        // By tick % NET_HISTORY
+    Sint8 remote_inputs[NET_HISTORY];       // Confirmed, or the prediction that was used
+    Uint32 remote_confirmed;                // Remote input known for every tick before this
+    Uint32 local_acked;                     // Peer has our input for every tick before this
+    Uint32 rollback_from;                   // Earliest mispredicted tick, or NET_NO_ROLLBACK
+    Match snapshots[NET_HISTORY];           // State before each tick
+
+    // Latest checksum of a confirmed state from the peer, compared once we have that state too
+    Uint32 remote_checksum_tick;
+    Uint64 remote_checksum;
+    Uint32 checked_tick;                    // Last tick compared, so a desync is counted once
+
+    NetConditions conditions;
+    Uint64 rng_state;                       // For packet loss
+    DelayedPacket delayed[NET_DELAY_QUEUE]; // Ring of packets waiting out conditions.delay_ms
+    int delayed_first;
+    int delayed_count;
+
+    // Statistics reported by net_close()
+    int rollbacks;
+    Uint64 resimulated_ticks;
+    Uint32 longest_rollback;
+    int stalls;
+    int desyncs;
+} NetSession;
+
+const Uint32 NET_NO_ROLLBACK = 0xFFFFFFFF;
+
+// Wait on 'port' for a client; the match will use 'seed' and 'config'
+bool net_host(NetSession *net, Uint16 port, Uint64 seed, const MatchConfig *config, const NetConditions *conditions);
+
+// Connect to a host at 'address' ("host:port")
+bool net_connect(NetSession *net, const char *address, const NetConditions *conditions);
+
+/* Read everything that has arrived. Starts 'match' once both peers are connected, and
+   rolls it back and forward again if the peer's inputs differ from the predictions.
+   Returns true if 'match' was replaced that way. */
+bool net_poll(NetSession *net, Match *match);
+
+/* Simulate one tick with 'local' as this peer's input. Returns the MatchEvent mask, or -1
+   if the match hasn't started or is too far ahead of the peer and has to wait. */
+int net_advance(NetSession *net, Match *match, Directions local);
+
+// Send this frame's inputs and any delayed packets that are due
+void net_flush(NetSession *net);
+
+void net_close(NetSession *net);
+
+#endif
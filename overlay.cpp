@@ -0,0 +1,222 @@
+#include "overlay.h"
+#include "trace.h"
+
+static const char *PHASE_NAMES[FRAME_PHASE_COUNT] = {"events", "simulation", "render", "present"};
+
+static int bucket_of(float ms) {
+    int bucket = (int) (ms / OVERLAY_BUCKET_MS);
+    return SDL_clamp(bucket, 0, OVERLAY_BUCKETS - 1);
+}
+
+// Sample 'age' frames back from the newest
+static const FrameSample *sample_at(const FrameOverlay *overlay, int age) {
+    return &overlay->samples[(overlay->next - 1 - age + OVERLAY_SAMPLES) % OVERLAY_SAMPLES];
+}
+
+static int window_size(const FrameOverlay *overlay) {
+    return SDL_min(overlay->count, OVERLAY_WINDOW);
+}
+
+// Bucket holding the 'fraction' percentile of the window
+static int percentile_bucket(const FrameOverlay *overlay, float fraction) {
+    const int target = (int) SDL_ceilf(window_size(overlay) * fraction);
+    int seen = 0;
+    for (int i = 0; i < OVERLAY_BUCKETS - 1; i++) {
+        seen += overlay->buckets[i];
+        if (seen >= target) {
+            return i;
+        }
+    }
+    return OVERLAY_BUCKETS - 1;
+}
+
+typedef struct LatencySummary {
+    int count;
+    float mean_ms;
+    float p50_ms;
+    float p99_ms;
+    float max_ms;
+    float stddev_ms;
+} LatencySummary;
+
+static int compare_floats(const void *a, const void *b) {
+    const float x = *(const float *) a;
+    const float y = *(const float *) b;
+    return (x > y) - (x < y);
+}
+
+static void summarise_latency(const FrameOverlay *overlay, LatencySummary *summary) {
+    SDL_zerop(summary);
+    summary->count = overlay->latency_count;
+    if (summary->count == 0) {
+        return;
+    }
+    float sorted[OVERLAY_LATENCIES];
+    SDL_memcpy(sorted, overlay->latency_ms, summary->count * sizeof(float));
+    SDL_qsort(sorted, summary->count, sizeof(float), compare_floats);
+
+    double sum = 0;
+    double sum_squares = 0;
+    for (int i = 0; i < summary->count; i++) {
+        sum += sorted[i];
+        sum_squares += (double) sorted[i] * sorted[i];
+    }
+    const double mean = sum / summary->count;
+    summary->mean_ms = (float) mean;
+    summary->stddev_ms = (float) SDL_sqrt(SDL_max(sum_squares / summary->count - mean * mean, 0.0));
+    summary->p50_ms = sorted[(summary->count - 1) / 2];
+    summary->p99_ms = sorted[(int) ((summary->count - 1) * 0.99f)];
+    summary->max_ms = sorted[summary->count - 1];
+}
+
+void overlay_init(FrameOverlay *overlay) {
+    SDL_zerop(overlay);
+}
+
+void overlay_add_phase(FrameOverlay *overlay, FramePhase phase, Uint64 ns) {
+    overlay->pending_phase_ms[phase] += (float) ns / SDL_NS_PER_MS;
+}
+
+void overlay_end_frame(FrameOverlay *overlay, Uint64 now_ns) {
+    // The first frame has nothing to be measured from
+    if (overlay->last_frame_ns == 0) {
+        overlay->last_frame_ns = now_ns;
+        SDL_zeroa(overlay->pending_phase_ms);
+        return;
+    }
+
+    // Drop the frame leaving the window from the running totals
+    if (overlay->count >= OVERLAY_WINDOW) {
+        const FrameSample *old = sample_at(overlay, OVERLAY_WINDOW - 1);
+        overlay->buckets[bucket_of(old->frame_ms)]--;
+        for (int phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+            overlay->window_phase_ms[phase] -= old->phase_ms[phase];
+        }
+    }
+
+    FrameSample *sample = &overlay->samples[overlay->next];
+    sample->frame_ms = (float) (now_ns - overlay->last_frame_ns) / SDL_NS_PER_MS;
+    overlay->buckets[bucket_of(sample->frame_ms)]++;
+    for (int phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+        sample->phase_ms[phase] = overlay->pending_phase_ms[phase];
+        overlay->window_phase_ms[phase] += sample->phase_ms[phase];
+        overlay->pending_phase_ms[phase] = 0;
+    }
+
+    overlay->next = (overlay->next + 1) % OVERLAY_SAMPLES;
+    overlay->count = SDL_min(overlay->count + 1, OVERLAY_SAMPLES);
+    overlay->frames++;
+    overlay->last_frame_ns = now_ns;
+}
+
+void overlay_add_input_latency(FrameOverlay *overlay, Uint64 ns) {
+    overlay->latency_ms[overlay->latency_next] = (float) ns / SDL_NS_PER_MS;
+    overlay->latency_next = (overlay->latency_next + 1) % OVERLAY_LATENCIES;
+    overlay->latency_count = SDL_min(overlay->latency_count + 1, OVERLAY_LATENCIES);
+}
+
+void overlay_log_input_latency(const FrameOverlay *overlay) {
+    LatencySummary latency;
+    summarise_latency(overlay, &latency);
+    if (latency.count > 0) {
+        SDL_Log("Input to present over last %d presses: mean %.2f ms, p50 %.2f, p99 %.2f, max %.2f, stddev %.2f",
+                latency.count, latency.mean_ms, latency.p50_ms, latency.p99_ms, latency.max_ms, latency.stddev_ms);
+    }
+}
+
+void overlay_draw(const FrameOverlay *overlay, SDL_Renderer *renderer) {
+    const int frames = window_size(overlay);
+    if (!overlay->visible || frames == 0) {
+        return;
+    }
+    TRACE_ZONE("overlay");
+
+    float max_ms = 0;
+    for (int age = 0; age < frames; age++) {
+        max_ms = SDL_max(max_ms, sample_at(overlay, age)->frame_ms);
+    }
+    // Percentiles are reported as the upper edge of their bucket
+    const int p50 = percentile_bucket(overlay, 0.5f);
+    const int p99 = percentile_bucket(overlay, 0.99f);
+
+    SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+
+    const SDL_FRect box = {8, 8, 424, 100};
+    SDL_SetRenderDrawColor(renderer, 16, 24, 32, SDL_ALPHA_OPAQUE);
+    SDL_RenderFillRect(renderer, &box);
+
+    SDL_SetRenderDrawColor(renderer, 151, 188, 98, SDL_ALPHA_OPAQUE);
+    SDL_RenderDebugTextFormat(renderer, 16, 16, "frame %6.2f ms  p50 %6.2f  p99 %6.2f  max %6.2f",
+                              sample_at(overlay, 0)->frame_ms, (p50 + 1) * OVERLAY_BUCKET_MS, (p99 + 1) * OVERLAY_BUCKET_MS, max_ms);
+    SDL_RenderDebugTextFormat(renderer, 16, 28, "avg   %s %.2f  %s %.2f",
+                              PHASE_NAMES[FRAME_PHASE_EVENTS], overlay->window_phase_ms[FRAME_PHASE_EVENTS] / frames,
+                              PHASE_NAMES[FRAME_PHASE_SIMULATION], overlay->window_phase_ms[FRAME_PHASE_SIMULATION] / frames);
+    SDL_RenderDebugTextFormat(renderer, 16, 40, "      %s %.2f  %s %.2f",
+                              PHASE_NAMES[FRAME_PHASE_RENDER], overlay->window_phase_ms[FRAME_PHASE_RENDER] / frames,
+                              PHASE_NAMES[FRAME_PHASE_PRESENT], overlay->window_phase_ms[FRAME_PHASE_PRESENT] / frames);
+
+    LatencySummary latency;
+    summarise_latency(overlay, &latency);
+    if (latency.count > 0) {
+        SDL_RenderDebugTextFormat(renderer, 16, 52, "input %6.2f ms  p50 %6.2f  p99 %6.2f  sd %5.2f",
+                                  overlay->latency_ms[(overlay->latency_next - 1 + OVERLAY_LATENCIES) % OVERLAY_LATENCIES],
+                                  latency.p50_ms, latency.p99_ms, latency.stddev_ms);
+    }
+
+    // Histogram of the window, one pixel column per bucket, tallest bucket full height
+    const float left = 16;
+    const float bottom = 100;
+    const float height = 36;
+    int tallest = 1;
+    for (int i = 0; i < OVERLAY_BUCKETS; i++) {
+        tallest = SDL_max(tallest, overlay->buckets[i]);
+    }
+
+    SDL_SetRenderDrawColor(renderer, 242, 170, 76, SDL_ALPHA_OPAQUE);
+    for (int i = 0; i < OVERLAY_BUCKETS; i++) {
+        if (overlay->buckets[i] > 0) {
+            const float bar = SDL_max(1.0f, height * overlay->buckets[i] / tallest);
+            SDL_RenderLine(renderer, left + i, bottom, left + i, bottom - bar);
+        }
+    }
+
+    // Percentile markers
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
+    SDL_RenderLine(renderer, left + p50, bottom, left + p50, bottom - height);
+    SDL_SetRenderDrawColor(renderer, 233, 75, 60, SDL_ALPHA_OPAQUE);
+    SDL_RenderLine(renderer, left + p99, bottom, left + p99, bottom - height);
+
+    SDL_SetRenderDrawColor(renderer, 151, 188, 98, SDL_ALPHA_OPAQUE);
+    SDL_RenderDebugTextFormat(renderer, left + OVERLAY_BUCKETS + 8, bottom - 8, "0-%.0f ms", OVERLAY_BUCKETS * OVERLAY_BUCKET_MS);
+}
+
+bool overlay_write_csv(const FrameOverlay *overlay, const char *path) {
+    SDL_IOStream *io = SDL_IOFromFile(path, "w");
+    if (!io) {
+        SDL_Log("Couldn't create '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    SDL_IOprintf(io, "frame,frame_ms");
+    for (int phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+        SDL_IOprintf(io, ",%s_ms", PHASE_NAMES[phase]);
+    }
+    SDL_IOprintf(io, "\n");
+
+    const Uint64 first = overlay->frames - overlay->count;
+    for (int age = overlay->count - 1; age >= 0; age--) {
+        const FrameSample *sample = sample_at(overlay, age);
+        SDL_IOprintf(io, "%" SDL_PRIu64 ",%.4f", first + (overlay->count - 1 - age), sample->frame_ms);
+        for (int phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+            SDL_IOprintf(io, ",%.4f", sample->phase_ms[phase]);
+        }
+        SDL_IOprintf(io, "\n");
+    }
+
+    if (!SDL_CloseIO(io)) {
+        SDL_Log("Couldn't write '%s': %s", path, SDL_GetError());
+        return false;
+    }
+    SDL_Log("Wrote %d frame times to '%s'", overlay->count, path);
+    return true;
+}
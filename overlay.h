@@ -0,0 +1,80 @@
+/* Frame-time overlay: per-frame timings of each phase of a frame, kept in a fixed ring
+ * buffer, summarised as percentiles and a histogram drawn over the current screen.
+ * It also keeps the input latency probe: for each key press, the time from the event's
+ * timestamp to the end of the SDL_RenderPresent() of the first frame that shows it.
+ * Nothing here allocates after startup.
+ */
+
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <SDL3/SDL.h>
+
+// Parts of a frame that are timed separately
+enum FramePhase {
+    FRAME_PHASE_EVENTS = 0,     // SDL_AppEvent() calls since the last frame
+    FRAME_PHASE_SIMULATION,     // Fixed ticks of match_step()
+    FRAME_PHASE_RENDER,         // Building the frame's draw calls
+    FRAME_PHASE_PRESENT,        // SDL_RenderPresent()
+    FRAME_PHASE_COUNT
+};
+
+// Frames kept for the CSV dump (about a minute at 60 Hz)
+const int OVERLAY_SAMPLES = 4096;
+
+// Most recent frames the percentiles and histogram are taken over
+const int OVERLAY_WINDOW = 512;
+
+// Histogram buckets of 0.25 ms; the last one also holds anything slower
+const int OVERLAY_BUCKETS = 200;
+const float OVERLAY_BUCKET_MS = 0.25f;
+
+// Most recent input latencies kept
+const int OVERLAY_LATENCIES = 256;
+
+typedef struct FrameSample {
+    float frame_ms;                         // Since the end of the previous frame
+    float phase_ms[FRAME_PHASE_COUNT];
+} FrameSample;
+
+typedef struct FrameOverlay {
+    bool visible;
+
+    FrameSample samples[OVERLAY_SAMPLES];
+    int next;                   // Where the next sample goes
+    int count;                  // Samples held, up to OVERLAY_SAMPLES
+    Uint64 frames;              // Frames ever recorded
+
+    // Running totals over the last OVERLAY_WINDOW frames
+    int buckets[OVERLAY_BUCKETS];
+    double window_phase_ms[FRAME_PHASE_COUNT];
+
+    float pending_phase_ms[FRAME_PHASE_COUNT];  // Frame in progress
+    Uint64 last_frame_ns;
+
+    float latency_ms[OVERLAY_LATENCIES];        // Ring of input latencies
+    int latency_next;
+    int latency_count;
+} FrameOverlay;
+
+void overlay_init(FrameOverlay *overlay);
+
+// Add 'ns' nanoseconds spent in 'phase' to the frame in progress
+void overlay_add_phase(FrameOverlay *overlay, FramePhase phase, Uint64 ns);
+
+// Close the frame in progress at time 'now_ns' (from SDL_GetTicksNS())
+void overlay_end_frame(FrameOverlay *overlay, Uint64 now_ns);
+
+// Record an input that reached the screen 'ns' nanoseconds after its event
+void overlay_add_input_latency(FrameOverlay *overlay, Uint64 ns);
+
+// Log a summary of the input latencies kept, if there are any
+void overlay_log_input_latency(const FrameOverlay *overlay);
+
+// Draw the overlay in game coordinates if it is visible
+void overlay_draw(const FrameOverlay *overlay, SDL_Renderer *renderer);
+
+// Write every sample still in the ring buffer to 'path', oldest first
+bool overlay_write_csv(const FrameOverlay *overlay, const char *path);
+
+#endif
@@ -0,0 +1,91 @@
+#include "pacing.h"
+
+void pacing_init(FramePacer *pacer) {
+    SDL_zerop(pacer);
+    pacer->mode = F_UNCAPPED;
+    pacer->spin_ns = SDL_NS_PER_MS;
+}
+
+// Frames per second of a capped mode, or 0
+static int cap_fps(FramePacing mode) {
+    if (mode == F_CAP_30) {
+        return 30;
+    } else if (mode == F_CAP_60) {
+        return 60;
+    } else if (mode == F_CAP_144) {
+        return 144;
+    }
+    return 0;
+}
+
+bool pacing_set_mode(FramePacer *pacer, SDL_Renderer *renderer, FramePacing mode) {
+    int vsync = SDL_RENDERER_VSYNC_DISABLED;
+    if (mode == F_VSYNC) {
+        vsync = 1;
+    } else if (mode == F_ADAPTIVE) {
+        vsync = SDL_RENDERER_VSYNC_ADAPTIVE;
+    }
+
+    if (!SDL_SetRenderVSync(renderer, vsync)) {
+        SDL_Log("Couldn't set VSync %d: %s", vsync, SDL_GetError());
+        // Adaptive VSync isn't available everywhere; plain VSync is the next best
+        if (mode != F_ADAPTIVE || !SDL_SetRenderVSync(renderer, 1)) {
+            return false;
+        }
+    }
+
+    pacer->mode = mode;
+    const int fps = cap_fps(mode);
+    pacer->frame_ns = fps > 0 ? SDL_NS_PER_SECOND / fps : 0;
+    pacer->deadline_ns = 0;
+    return true;
+}
+
+void pacing_wait(FramePacer *pacer) {
+    if (pacer->frame_ns == 0) {
+        return;
+    }
+
+    Uint64 now = SDL_GetTicksNS();
+    if (pacer->deadline_ns == 0) {
+        pacer->deadline_ns = now;
+    }
+    pacer->deadline_ns += pacer->frame_ns;
+    pacer->waits++;
+
+    // Already late; if by more than a frame, start afresh rather than rushing to catch up
+    if (now >= pacer->deadline_ns) {
+        pacer->missed_deadlines++;
+        if (now - pacer->deadline_ns > pacer->frame_ns) {
+            pacer->deadline_ns = now;
+        }
+        return;
+    }
+
+    // Sleep up to the spun stretch before the deadline, then learn from how late that woke
+    if (pacer->deadline_ns - now > pacer->spin_ns) {
+        const Uint64 wake_ns = pacer->deadline_ns - pacer->spin_ns;
+        SDL_DelayNS(wake_ns - now);
+        now = SDL_GetTicksNS();
+        const Uint64 overshoot = now > wake_ns ? now - wake_ns : 0;
+        if (overshoot > pacer->spin_ns) {
+            pacer->late_wakeups++;
+            pacer->spin_ns = SDL_min(overshoot + overshoot / 4, PACING_MAX_SPIN_NS);
+        } else {
+            // Creep back down while sleeps are on time, so little is spent spinning
+            pacer->spin_ns = SDL_max(pacer->spin_ns - pacer->spin_ns / 64, PACING_MIN_SPIN_NS);
+        }
+    }
+
+    while (now < pacer->deadline_ns) {
+        now = SDL_GetTicksNS();
+    }
+}
+
+void pacing_log(const FramePacer *pacer) {
+    if (pacer->waits == 0) {
+        return;
+    }
+    SDL_Log("Frame cap: %" SDL_PRIu64 " frames, %" SDL_PRIu64 " missed deadlines, %" SDL_PRIu64 " late wakeups, spinning %.2f ms",
+            pacer->waits, pacer->missed_deadlines, pacer->late_wakeups, (double) pacer->spin_ns / SDL_NS_PER_MS);
+}
@@ -0,0 +1,40 @@
+/* Frame pacing: the FramePacing option of the CONFIG menu. VSync and adaptive VSync
+ * leave the waiting to SDL_RenderPresent(); the capped modes turn VSync off and wait
+ * for the next frame's deadline themselves. Most of that wait is slept, and the last
+ * stretch is spun on the clock, since sleeps can overshoot by a millisecond or more.
+ * The spun stretch adapts to how late the sleeps have actually been waking up.
+ */
+
+#ifndef PACING_H
+#define PACING_H
+
+#include <SDL3/SDL.h>
+#include "scenes.h"
+
+// Bounds of the stretch before a deadline spun rather than slept
+const Uint64 PACING_MIN_SPIN_NS = 200 * SDL_NS_PER_US;
+const Uint64 PACING_MAX_SPIN_NS = 4 * SDL_NS_PER_MS;
+
+typedef struct FramePacer {
+    FramePacing mode;
+    Uint64 frame_ns;        // Frame period of a capped mode, 0 otherwise
+    Uint64 deadline_ns;     // When the next frame is due, in SDL_GetTicksNS() time
+    Uint64 spin_ns;         // Current spun stretch
+
+    // Since pacing_init(), for the log at exit
+    Uint64 waits;
+    Uint64 late_wakeups;    // Sleeps that overshot the spun stretch
+    Uint64 missed_deadlines;
+} FramePacer;
+
+void pacing_init(FramePacer *pacer);
+
+// Switch to 'mode', setting the renderer's VSync to suit; false if the driver refused it
+bool pacing_set_mode(FramePacer *pacer, SDL_Renderer *renderer, FramePacing mode);
+
+// In a capped mode, wait for the next frame's deadline; call once at the end of each frame
+void pacing_wait(FramePacer *pacer);
+
+void pacing_log(const FramePacer *pacer);
+
+#endif
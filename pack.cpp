@@ -0,0 +1,186 @@
+/* pong_pack: build the asset bundle the game maps at startup (see bundle.h) from .wav files.
+ *
+ * Usage: pong_pack [--rate HZ] [--adpcm] -o OUT.bundle FILE.wav...
+ *
+ * Every sound is converted to 16-bit stereo at --rate (default 48000, what most devices
+ * ask for) so nothing is converted when it plays; --adpcm stores them at a quarter of
+ * the size. Entries are named after the file names, without directories.
+ */
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+#include "adpcm.h"
+#include "bundle.h"
+
+static const int PACK_CHANNELS = 2;
+static const int PACK_ALIGN = 16;
+
+typedef struct PackedSound {
+    char name[BUNDLE_NAME_SIZE];
+    Uint32 codec;
+    Uint32 frames;
+    Uint8 *data;
+    Uint32 size;
+} PackedSound;
+
+static const char *base_name(const char *path) {
+    const char *name = path;
+    for (const char *p = path; *p; p++) {
+        if (*p == '/' || *p == '\\') {
+            name = p + 1;
+        }
+    }
+    return name;
+}
+
+static bool pack_sound(PackedSound *packed, const char *path, const SDL_AudioSpec *target, bool adpcm) {
+    SDL_zerop(packed);
+    const char *name = base_name(path);
+    if (SDL_strlen(name) >= (size_t) BUNDLE_NAME_SIZE) {
+        SDL_Log("Name '%s' is too long for the bundle", name);
+        return false;
+    }
+    SDL_strlcpy(packed->name, name, sizeof(packed->name));
+
+    SDL_AudioSpec spec;
+    Uint8 *wav_data = NULL;
+    Uint32 wav_data_len = 0;
+    if (!SDL_LoadWAV(path, &spec, &wav_data, &wav_data_len)) {
+        SDL_Log("Couldn't load '%s': %s", path, SDL_GetError());
+        return false;
+    }
+    Uint8 *pcm = NULL;
+    int pcm_len = 0;
+    const bool converted = SDL_ConvertAudioSamples(&spec, wav_data, (int) wav_data_len, target, &pcm, &pcm_len);
+    SDL_free(wav_data);
+    if (!converted) {
+        SDL_Log("Couldn't convert '%s': %s", path, SDL_GetError());
+        return false;
+    }
+    packed->frames = (Uint32) (pcm_len / SDL_AUDIO_FRAMESIZE(*target));
+
+    if (!adpcm) {
+        packed->codec = BUNDLE_CODEC_S16;
+        packed->data = pcm;
+        packed->size = packed->frames * SDL_AUDIO_FRAMESIZE(*target);
+        return true;
+    }
+
+    const Uint32 blocks = (packed->frames + ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES;
+    const int block_size = adpcm_block_size(target->channels);
+    packed->codec = BUNDLE_CODEC_ADPCM;
+    packed->size = blocks * block_size;
+    packed->data = (Uint8 *) SDL_malloc(SDL_max(packed->size, 1));
+    if (!packed->data) {
+        SDL_free(pcm);
+        return false;
+    }
+    AdpcmChannel state[PACK_CHANNELS];
+    SDL_zeroa(state);
+    const Sint16 *samples = (const Sint16 *) pcm;
+    for (Uint32 i = 0; i < blocks; i++) {
+        const Uint32 first = i * ADPCM_BLOCK_FRAMES;
+        const int frames = (int) SDL_min((Uint32) ADPCM_BLOCK_FRAMES, packed->frames - first);
+        adpcm_encode_block(samples + (size_t) first * target->channels, frames, target->channels, state,
+                           packed->data + (size_t) i * block_size);
+    }
+    SDL_free(pcm);
+    return true;
+}
+
+static Uint64 align_up(Uint64 value) {
+    return (value + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+}
+
+static bool write_bundle(const char *path, const SDL_AudioSpec *spec, const PackedSound *sounds, int count) {
+    SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+    if (!io) {
+        SDL_Log("Couldn't create '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    bool ok = SDL_WriteIO(io, "PONGBNDL", 8) == 8 &&
+              SDL_WriteU32LE(io, BUNDLE_VERSION) &&
+              SDL_WriteU32LE(io, (Uint32) count) &&
+              SDL_WriteU32LE(io, (Uint32) spec->freq) &&
+              SDL_WriteU16LE(io, (Uint16) spec->channels) &&
+              SDL_WriteU16LE(io, 0);
+
+    Uint64 offset = align_up(BUNDLE_HEADER_SIZE + (Uint64) count * BUNDLE_ENTRY_SIZE);
+    for (int i = 0; i < count && ok; i++) {
+        ok = SDL_WriteIO(io, sounds[i].name, BUNDLE_NAME_SIZE) == (size_t) BUNDLE_NAME_SIZE &&
+             SDL_WriteU32LE(io, sounds[i].codec) &&
+             SDL_WriteU32LE(io, sounds[i].frames) &&
+             SDL_WriteU64LE(io, offset) &&
+             SDL_WriteU64LE(io, sounds[i].size);
+        offset = align_up(offset + sounds[i].size);
+    }
+
+    static const Uint8 padding[PACK_ALIGN] = {0};
+    for (int i = 0; i < count && ok; i++) {
+        const Sint64 position = SDL_TellIO(io);
+        const size_t pad = (size_t) (align_up((Uint64) position) - (Uint64) position);
+        ok = SDL_WriteIO(io, padding, pad) == pad &&
+             SDL_WriteIO(io, sounds[i].data, sounds[i].size) == sounds[i].size;
+    }
+
+    if (!SDL_CloseIO(io) || !ok) {
+        SDL_Log("Couldn't write '%s': %s", path, SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const char *out_path = NULL;
+    SDL_AudioSpec target = {SDL_AUDIO_S16, PACK_CHANNELS, 48000};
+    bool adpcm = false;
+    int first_input = argc;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (SDL_strcmp(arg, "--adpcm") == 0) {
+            adpcm = true;
+        } else if (SDL_strcmp(arg, "--rate") == 0 && i + 1 < argc) {
+            target.freq = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(arg, "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (arg[0] == '-') {
+            SDL_Log("Unknown option '%s'", arg);
+            return 1;
+        } else {
+            first_input = i;
+            break;
+        }
+    }
+    const int count = argc - first_input;
+    if (out_path == NULL || count == 0 || target.freq <= 0) {
+        SDL_Log("Usage: pong_pack [--rate HZ] [--adpcm] -o OUT.bundle FILE.wav...");
+        return 1;
+    }
+
+    PackedSound *sounds = (PackedSound *) SDL_calloc(count, sizeof(PackedSound));
+    if (!sounds) {
+        return 1;
+    }
+    bool ok = true;
+    for (int i = 0; i < count && ok; i++) {
+        ok = pack_sound(&sounds[i], argv[first_input + i], &target, adpcm);
+    }
+    if (ok) {
+        ok = write_bundle(out_path, &target, sounds, count);
+    }
+
+    Uint64 total = 0;
+    for (int i = 0; i < count; i++) {
+        total += sounds[i].size;
+        SDL_free(sounds[i].data);
+    }
+    SDL_free(sounds);
+    if (ok) {
+        SDL_Log("Packed %d sounds, %" SDL_PRIu64 " KB of %s at %d Hz, into '%s'",
+                count, total / 1024, adpcm ? "ADPCM" : "16-bit PCM", target.freq, out_path);
+    }
+    SDL_Quit();
+    return ok ? 0 : 1;
+}
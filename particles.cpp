@@ -0,0 +1,130 @@
+#include "particles.h"
+
+/* Hand out the next 'capacity' elements of the pool allocation */
+template <typename T>
+static T *take_array(Uint8 **next, int capacity) {
+    T *array = (T *) *next;
+    *next += capacity * sizeof(T);
+    return array;
+}
+
+bool particles_create(ParticleSystem *particles, int capacity, Uint64 seed) {
+    SDL_zerop(particles);
+
+    // A multiple of 8 keeps every array on a 32 byte boundary
+    capacity = ((capacity + 7) / 8) * 8;
+    const size_t bytes = capacity * (7 * sizeof(float) + sizeof(SDL_FColor));
+    Uint8 *memory = (Uint8 *) SDL_aligned_alloc(32, bytes);
+    if (!memory) {
+        return false;
+    }
+    SDL_memset(memory, 0, bytes);
+
+    if (!geometry_create(&particles->geometry, capacity)) {
+        SDL_aligned_free(memory);
+        return false;
+    }
+
+    particles->capacity = capacity;
+    particles->memory = memory;
+    particles->rng_state = seed;
+
+    Uint8 *next = memory;
+    particles->x = take_array<float>(&next, capacity);
+    particles->y = take_array<float>(&next, capacity);
+    particles->velocity_x = take_array<float>(&next, capacity);
+    particles->velocity_y = take_array<float>(&next, capacity);
+    particles->age = take_array<float>(&next, capacity);
+    particles->lifetime = take_array<float>(&next, capacity);
+    particles->size = take_array<float>(&next, capacity);
+    particles->color = take_array<SDL_FColor>(&next, capacity);
+    return true;
+}
+
+void particles_destroy(ParticleSystem *particles) {
+    geometry_destroy(&particles->geometry);
+    SDL_aligned_free(particles->memory);
+    SDL_zerop(particles);
+}
+
+void particles_clear(ParticleSystem *particles) {
+    particles->count = 0;
+}
+
+// Random value between 'min' and 'max'
+static float random_between(ParticleSystem *particles, float min, float max) {
+    return min + (max - min) * SDL_randf_r(&particles->rng_state);
+}
+
+void particles_emit(ParticleSystem *particles, const ParticleEmitter *emitter, float x, float y) {
+    const int room = particles->capacity - particles->count;
+    const int count = SDL_min(emitter->count, room);
+    particles->dropped += emitter->count - count;
+
+    for (int n = 0; n < count; n++) {
+        const int i = particles->count++;
+        const float angle = emitter->angle + random_between(particles, -emitter->spread, emitter->spread);
+        const float speed = random_between(particles, emitter->speed_min, emitter->speed_max);
+        particles->x[i] = x;
+        particles->y[i] = y;
+        particles->velocity_x[i] = SDL_cosf(angle) * speed;
+        particles->velocity_y[i] = SDL_sinf(angle) * speed;
+        particles->age[i] = 0;
+        particles->lifetime[i] = random_between(particles, emitter->lifetime_min, emitter->lifetime_max);
+        particles->size[i] = emitter->size;
+        particles->color[i] = emitter->color;
+    }
+}
+
+void particles_update(ParticleSystem *particles, float dt) {
+    const float damping = 1 / (1 + PARTICLE_DRAG * dt);
+
+    for (int i = 0; i < particles->count; i++) {
+        particles->velocity_x[i] *= damping;
+        particles->velocity_y[i] *= damping;
+        particles->x[i] += particles->velocity_x[i] * dt;
+        particles->y[i] += particles->velocity_y[i] * dt;
+        particles->age[i] += dt;
+    }
+
+    // Fill each expired slot with the last live particle, keeping the live ones packed
+    int i = 0;
+    while (i < particles->count) {
+        if (particles->age[i] < particles->lifetime[i]) {
+            i++;
+            continue;
+        }
+        const int last = --particles->count;
+        particles->x[i] = particles->x[last];
+        particles->y[i] = particles->y[last];
+        particles->velocity_x[i] = particles->velocity_x[last];
+        particles->velocity_y[i] = particles->velocity_y[last];
+        particles->age[i] = particles->age[last];
+        particles->lifetime[i] = particles->lifetime[last];
+        particles->size[i] = particles->size[last];
+        particles->color[i] = particles->color[last];
+    }
+}
+
+void particles_draw(ParticleSystem *particles, SDL_Renderer *renderer) {
+    if (particles->count == 0) {
+        return;
+    }
+
+    geometry_clear(&particles->geometry);
+    for (int i = 0; i < particles->count; i++) {
+        const float left = 1 - particles->age[i] / particles->lifetime[i];
+        const float size = particles->size[i] * left;
+        const SDL_FRect rect = {particles->x[i] - size/2, particles->y[i] - size/2, size, size};
+        SDL_FColor color = particles->color[i];
+        color.a *= left;
+        geometry_add_rect(&particles->geometry, &rect, color);
+    }
+
+    // Untextured geometry blends with the renderer's draw blend mode
+    SDL_BlendMode blend_mode = SDL_BLENDMODE_NONE;
+    SDL_GetRenderDrawBlendMode(renderer, &blend_mode);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    geometry_draw(&particles->geometry, renderer, NULL);
+    SDL_SetRenderDrawBlendMode(renderer, blend_mode);
+}
@@ -0,0 +1,64 @@
+/* Particles: sparks, bursts and trails drawn over the GAME scene. The pool is allocated
+ * once with a fixed capacity; emitting into a full pool drops the new particles, so the
+ * cost of a frame is bounded however many effects fire. Live particles are packed at the
+ * front of structure-of-arrays storage, updated in one loop and drawn with one
+ * SDL_RenderGeometry() call.
+ */
+
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <SDL3/SDL.h>
+#include "geometry.h"
+
+// What one emission looks like; each particle picks its own values within the ranges
+typedef struct ParticleEmitter {
+    int count;
+    float angle;            // Direction in radians, 0 is towards +x, and how far either side of it
+    float spread;
+    float speed_min;        // px/s
+    float speed_max;
+    float lifetime_min;     // Seconds
+    float lifetime_max;
+    float size;             // Starting width in px; shrinks to nothing over the lifetime
+    SDL_FColor color;       // Alpha fades out over the lifetime too
+} ParticleEmitter;
+
+typedef struct ParticleSystem {
+    int count;
+    int capacity;
+
+    float *x;               // Centre
+    float *y;
+    float *velocity_x;
+    float *velocity_y;
+    float *age;
+    float *lifetime;
+    float *size;
+    SDL_FColor *color;
+
+    Uint64 rng_state;
+    void *memory;           // Single allocation backing the arrays above
+    Geometry geometry;      // One quad per particle
+
+    Uint64 dropped;         // Particles that didn't fit in the pool
+} ParticleSystem;
+
+// How quickly particles slow down; every update divides their velocity by 1 + PARTICLE_DRAG * dt
+const float PARTICLE_DRAG = 3;
+
+bool particles_create(ParticleSystem *particles, int capacity, Uint64 seed);
+void particles_destroy(ParticleSystem *particles);
+
+// Remove every particle, eg after a jump in a replay
+void particles_clear(ParticleSystem *particles);
+
+// Emit 'emitter->count' particles at (x, y), as many as the pool has room for
+void particles_emit(ParticleSystem *particles, const ParticleEmitter *emitter, float x, float y);
+
+// Age and move every particle by 'dt' seconds, removing those that have expired
+void particles_update(ParticleSystem *particles, float dt);
+
+void particles_draw(ParticleSystem *particles, SDL_Renderer *renderer);
+
+#endif
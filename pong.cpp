@@ -10,27 +10,23 @@
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 #include <iostream>
-
-// Which window is being displayed (eg main menu or options menu)
-enum Window {MAIN = 0, CONFIG = 1, GAME = 2};
-
-// Choices in main menu
-enum Menu {PLAY = 0, OPTIONS = 1, QUIT = 2};
-
-// Choices in option menu
-enum Option {RESOLUTION = 0, FULLSCREEN = 1, AUDIO = 2, BALL_SPEED = 3, PADDLE_SPEED = 4, APPLY = 5, BACK = 6};
-
-// List of available resolutions
-enum Resolution {VGA = 0, SVGA = 1, HD = 2, XGA = 3, WXGA = 4, SXGA = 5, FHD = 6, QHD = 7};
-
-// Ball speed levels
-enum BallSpeed {B_LOW = 0, B_MEDIUM = 1, B_HIGH = 2};
-
-// Paddle speed levels
-enum PaddleSpeed {P_LOW = 0, P_MEDIUM = 1, P_HIGH = 2};
-
-// Direction that ball and paddle can go
-enum Directions {UP = 1, DOWN = -1, ZERO = 0};
+#include "match.h"
+#include "headless.h"
+#include "tournament.h"
+#include "capture.h"
+#include "replay.h"
+#include "overlay.h"
+#include "scenes.h"
+#include "mixer.h"
+#include "bundle.h"
+#include "loader.h"
+#include "music.h"
+#include "net.h"
+#include "swarm.h"
+#include "particles.h"
+#include "pacing.h"
+#include "timeline.h"
+#include "trace.h"
 
 // Corresponding enum variables
 static Window window_choice = MAIN;
@@ -39,11 +35,8 @@ static Option options_choice = RESOLUTION;
 static Resolution resolution_choice = VGA;
 static BallSpeed ball_speed_difficulty = B_MEDIUM;
 static PaddleSpeed paddle_speed_difficulty = P_MEDIUM;
-
-static Directions s_direction_player = ZERO;
-static Directions s_direction_cpu = UP;
-static Directions s_direction_ball_x = UP;
-static Directions s_direction_ball_y = DOWN;
+static CpuLevel cpu_level = C_MEDIUM;
+static FramePacing pacing_choice = F_VSYNC;
 
 static SDL_Window *window = NULL;
 static SDL_Renderer *renderer = NULL;
@@ -53,78 +46,513 @@ static SDL_AudioDeviceID audio_device = 0;
 static int WINDOW_WIDTH = 640;
 static int WINDOW_HEIGHT = 480;
 
-// Actual game's resolution
-static const int GAME_WIDTH = 640;
-static const int GAME_HEIGHT = 480;
-
 static bool is_fullscreen = true;
 static bool is_audio_enabled = true;
 
-// Delay between selecting PLAY and loading the actual game; needed to play SFX and flash option
-static int play_timer = 0;
+// Frame rate option as applied, and the wait for capped frame rates
+static FramePacer s_pacer;
+
+/* Menus only change in response to an event or a timeline action, so they are drawn
+   once and then idle in SDL_WaitEventTimeout() until the next is due. The timeout keeps
+   background work going, eg reporting the loader's progress, without drawing anything. */
+static bool s_redraw = true;
+static const Sint32 MENU_IDLE_TIMEOUT_MS = 100;
+
+/* Choosing PLAY flashes it while start.wav plays, then fades into GAME. The switch is
+   cued by the mixer finishing the sound, or comes after the sound's length if it isn't
+   playing (eg audio off or not loaded yet). */
+static Timeline s_timeline;
+static int s_play_flash = -1;       // Timeline id of the flashing, -1 before PLAY is chosen
+static bool s_show_play = true;
+static Uint32 s_start_finished = 0; // mixer_finished() for start.wav when PLAY was chosen
+static float s_game_fade = 0;       // Opacity of black over GAME as it fades in
+static const Uint64 START_SOUND_NS = SDL_MS_TO_NS(2845);     // 501760 bytes at 44.1 kHz, 16-bit stereo
+static const Uint64 PLAY_FLASH_PERIOD_NS = SDL_MS_TO_NS(250);
+static const Uint64 GAME_FADE_NS = SDL_MS_TO_NS(400);
 
 // Default for both is MEDIUM
 static float ball_speed_multiplier = 0.5;
 static float paddle_speed_multiplier = 0.5;
 
-// Place player and CPU paddles little below upper wall
-static float s_position_player_y = 100;
-static float s_position_cpu_y = 100;
+// The match being played (paddles, ball, scores)
+static Match s_match;
+
+// Seed of the match's serves; printed at start so a match can be played again with --seed
+static Uint64 s_seed = 0;
+
+// --record writes the match to a replay file, --replay plays one back instead of the keyboard
+static const char *s_record_path = NULL;
+static ReplayWriter s_recording;
+static bool s_replaying = false;
+static ReplayReader s_replay;
+
+// How far Left/Right jump while watching a replay
+static const float REPLAY_SEEK_SECONDS = 5;
+
+// Arrow keys held on the game screen, as of the tick being simulated
+static Directions s_input_direction = ZERO;
+
+/* Arrow key changes with their event timestamps, oldest first. Each takes effect in the
+   tick whose span of wall time it happened in, rather than at the next frame. */
+typedef struct InputEvent {
+    Uint64 timestamp_ns;
+    Directions direction;   // s_input_direction from then on
+} InputEvent;
+static const int INPUT_QUEUE_SIZE = 64;
+static InputEvent s_input_queue[INPUT_QUEUE_SIZE];
+static int s_input_first = 0;
+static int s_input_count = 0;
+
+// Timestamps of the inputs simulated this frame, for the latency probe once it is presented
+static Uint64 s_presented_inputs[INPUT_QUEUE_SIZE];
+static int s_presented_input_count = 0;
+
+// --host PORT or --connect HOST:PORT play a two-player match over UDP instead of against the CPU
+static Uint16 s_net_port = 0;
+static const char *s_net_address = NULL;
+static NetConditions s_net_conditions = {0, 0};
+static NetSession s_net;
+static bool s_netplay = false;
+
+// --autoplay steers the local paddle after the ball, eg to soak-test netplay unattended
+static bool s_autoplay = false;
+
+/* --stress N adds N small balls to the match, then keeps adding a tenth more every
+   STRESS_WINDOW_NS for as long as a frame at 60 fps would still fit in its budget, and
+   reports the most balls that fit at 60 and at 144 fps. The swarm's cost per tick and
+   the rest of the frame's are measured apart, as a frame at 60 fps runs more ticks. */
+static const int STRESS_MAX_BALLS = 32768;
+static const Uint64 STRESS_WINDOW_NS = SDL_NS_PER_SECOND / 2;
+static int s_stress_balls = 0;
+static BallSwarm s_swarm;
+static bool s_stress_ramping = true;
+static Uint64 s_stress_window_start = 0;
+static Uint64 s_stress_swarm_ns = 0;    // In swarm_step() this window
+static int s_stress_ticks = 0;
+static Uint64 s_stress_work_ns = 0;     // Frames this window, up to present
+static int s_stress_frames = 0;
+static int s_stress_sustained_60 = 0;
+static int s_stress_sustained_144 = 0;
+
+/* Sparks off the paddles, a burst where a goal went in, and a trail behind the ball.
+   Emitted by the simulated ticks, moved and faded once per frame. */
+static const int PARTICLES_MAX = 2048;
+static ParticleSystem s_particles;
+static const ParticleEmitter SPARKS = {24, 0, 1.2f, 80, 260, 0.15f, 0.4f, 3,
+                                       {242 / 255.0f, 170 / 255.0f, 76 / 255.0f, 1}};
+static const ParticleEmitter GOAL_BURST = {160, 0, 1.4f, 60, 420, 0.4f, 1.1f, 4,
+                                           {233 / 255.0f, 75 / 255.0f, 60 / 255.0f, 1}};
+static const ParticleEmitter BALL_TRAIL = {1, 0, SDL_PI_F, 0, 15, 0.1f, 0.2f, 6,
+                                           {233 / 255.0f, 75 / 255.0f, 60 / 255.0f, 0.5f}};
+
+// Emit 'emitter' at (x, y) with its angle turned to 'angle'
+static void emit_particles(const ParticleEmitter *emitter, float angle, float x, float y) {
+    ParticleEmitter turned = *emitter;
+    turned.angle = angle;
+    particles_emit(&s_particles, &turned, x, y);
+}
 
-// Place ball in middle of screen
-static float s_position_ball_x = GAME_WIDTH/2;
-static float s_position_ball_y = GAME_HEIGHT/2;
+// Frame timings, shown with F3 and written to --frame-csv on exit
+static FrameOverlay s_overlay;
+static const char *s_frame_csv_path = NULL;
+
+// F4 writes the trace zones recorded so far here (see trace.h)
+static const char *s_trace_path = "pong_trace.json";
+
+// Most ticks simulated in one frame, so a slow machine can't fall further and further behind
+static const int SIM_MAX_SUBSTEPS = 8;
+
+// Leftover time not yet consumed by a tick
+static float sim_accumulator = 0;
+
+// Positions as of the previous tick, used for render interpolation
+static float s_prev_position_player_y = 100;
+static float s_prev_position_cpu_y = 100;
+static float s_prev_position_ball_x = GAME_WIDTH/2;
+static float s_prev_position_ball_y = GAME_HEIGHT/2;
+
+// SDL_GetTicksNS() at the start of the previous frame
+static Uint64 last_time_ns = 0;
+
+// Sound effects, each a slot of s_mixer
+enum SoundEffect {
+    SFX_SCORE = 0,
+    SFX_MENU_SELECT,
+    SFX_START,
+    SFX_COUNT
+};
+static const char *EFFECT_FILES[SFX_COUNT] = {"score.wav", "menu_select.wav", "start.wav"};
+static Mixer s_mixer;
+
+// Background music, streamed from disk through a ring of --music-buffer-ms
+static MusicStream s_music;
+static int s_music_buffer_ms = MUSIC_DEFAULT_BUFFER_MS;
+
+// All sounds pre-converted in one mapped file, if pong.bundle is next to the executable
+static AssetBundle s_bundle;
+static bool s_has_bundle = false;
+
+/* The audio device and sounds load on a background thread so the menu shows on the first
+   frame; each is only used once its job is done, and a failed one is just left silent. */
+static AssetLoader s_loader;
+static int s_audio_job = -1;
+static int s_effect_jobs[SFX_COUNT];
+static int s_music_job = -1;
+static bool s_audio_option_applied = false;    // AUDIO option set on the device once it opened
+
+// For the time-to-first-frame and time-to-sounds reports
+static Uint64 s_startup_ns = 0;
+static bool s_first_frame_reported = false;
+static bool s_loading_reported = false;
+
+// Options for the interactive game: [--seed S] [--record FILE] [--replay FILE] [--frame-csv FILE]
+//                                    [--music-buffer-ms MS] [--host PORT | --connect HOST:PORT]
+//                                    [--net-delay-ms MS] [--net-loss PERCENT] [--autoplay] [--stress N]
+//                                    [--frame-rate vsync|adaptive|uncapped|30|60|144] [--trace FILE]
+static bool parse_game_options(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (SDL_strcmp(arg, "--autoplay") == 0) {
+            s_autoplay = true;
+            continue;
+        }
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (value == NULL) {
+            SDL_Log("Missing value for '%s'", arg);
+            return false;
+        }
 
-// Set a random x (and by extension random y) between 0.0 and 1.0
-static float s_component_ball_x = SDL_randf();
+        if (SDL_strcmp(arg, "--seed") == 0) {
+            s_seed = SDL_strtoull(value, NULL, 0);
+        } else if (SDL_strcmp(arg, "--record") == 0) {
+            s_record_path = value;
+        } else if (SDL_strcmp(arg, "--replay") == 0) {
+            if (!replay_reader_open(&s_replay, value)) {
+                return false;
+            }
+            s_replaying = true;
+        } else if (SDL_strcmp(arg, "--frame-csv") == 0) {
+            s_frame_csv_path = value;
+        } else if (SDL_strcmp(arg, "--trace") == 0) {
+            s_trace_path = value;
+        } else if (SDL_strcmp(arg, "--music-buffer-ms") == 0) {
+            s_music_buffer_ms = SDL_atoi(value);
+            if (s_music_buffer_ms < 20 || s_music_buffer_ms > 5000) {
+                SDL_Log("--music-buffer-ms must be between 20 and 5000");
+                return false;
+            }
+        } else if (SDL_strcmp(arg, "--host") == 0) {
+            const int port = SDL_atoi(value);
+            if (port <= 0 || port > 65535) {
+                SDL_Log("--host needs a UDP port");
+                return false;
+            }
+            s_net_port = (Uint16) port;
+        } else if (SDL_strcmp(arg, "--connect") == 0) {
+            s_net_address = value;
+        } else if (SDL_strcmp(arg, "--net-delay-ms") == 0) {
+            s_net_conditions.delay_ms = SDL_atoi(value);
+        } else if (SDL_strcmp(arg, "--net-loss") == 0) {
+            s_net_conditions.loss = (float) SDL_atof(value) / 100.0f;
+        } else if (SDL_strcmp(arg, "--frame-rate") == 0) {
+            if (SDL_strcmp(value, "vsync") == 0) {
+                pacing_choice = F_VSYNC;
+            } else if (SDL_strcmp(value, "adaptive") == 0) {
+                pacing_choice = F_ADAPTIVE;
+            } else if (SDL_strcmp(value, "uncapped") == 0) {
+                pacing_choice = F_UNCAPPED;
+            } else if (SDL_strcmp(value, "30") == 0) {
+                pacing_choice = F_CAP_30;
+            } else if (SDL_strcmp(value, "60") == 0) {
+                pacing_choice = F_CAP_60;
+            } else if (SDL_strcmp(value, "144") == 0) {
+                pacing_choice = F_CAP_144;
+            } else {
+                SDL_Log("--frame-rate must be vsync, adaptive, uncapped, 30, 60 or 144");
+                return false;
+            }
+        } else if (SDL_strcmp(arg, "--stress") == 0) {
+            s_stress_balls = SDL_atoi(value);
+            if (s_stress_balls < 1 || s_stress_balls > STRESS_MAX_BALLS) {
+                SDL_Log("--stress needs between 1 and %d balls", STRESS_MAX_BALLS);
+                return false;
+            }
+        } else {
+            SDL_Log("Unknown option '%s'", arg);
+            return false;
+        }
+        i++;
+    }
 
-static int s_score_player = 0;
-static int s_score_cpu = 0;
+    if (s_record_path != NULL && s_replaying) {
+        SDL_Log("--record and --replay can't be used together");
+        return false;
+    }
+    s_netplay = s_net_port != 0 || s_net_address != NULL;
+    if (s_net_port != 0 && s_net_address != NULL) {
+        SDL_Log("--host and --connect can't be used together");
+        return false;
+    }
+    if (s_netplay && (s_record_path != NULL || s_replaying)) {
+        SDL_Log("Netplay can't be recorded or replayed");
+        return false;
+    }
+    return true;
+}
 
-// Get the number of milliseconds elapsed in previous frame
-static Uint64 last_time = 0;
+// Loader job: open the audio device and the mixer, and map the asset bundle
+static bool load_audio(void *userdata) {
+    /* open the default audio device in whatever format it prefers; our audio streams will adjust to it. */
+    audio_device = SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, NULL);
+    if (audio_device == 0) {
+        SDL_Log("Couldn't open audio device: %s", SDL_GetError());
+        return false;
+    }
 
-/* things that are playing sound (the audiostream itself, plus the original data, so we can refill to loop. */
-typedef struct Sound {
-    Uint8 *wav_data;
-    Uint32 wav_data_len;
-    SDL_AudioStream *stream;
-} Sound;
+    char *bundle_path = NULL;
+    SDL_asprintf(&bundle_path, "%s%s", SDL_GetBasePath(), "pong.bundle");
+    s_has_bundle = bundle_open(&s_bundle, bundle_path);
+    if (!s_has_bundle) {
+        SDL_Log("No asset bundle (%s), loading .wav files", SDL_GetError());
+    }
+    SDL_free(bundle_path);
 
-static Sound sounds[4];
+    return mixer_open(&s_mixer, audio_device);
+}
 
-static bool init_sound(const char *fname, Sound *sound) {
-    bool retval = false;
-    SDL_AudioSpec spec;
-    char *wav_path = NULL;
+// Loader job: background music 'userdata' from the asset bundle, or from its .wav when there is none
+static bool load_music(void *userdata) {
+    const char *fname = (const char *) userdata;
+    if (s_mixer.stream == NULL) {
+        return false;
+    }
+    if (s_has_bundle) {
+        return music_open_bundle(&s_music, &s_bundle, fname, audio_device, s_music_buffer_ms);
+    }
+    return music_open(&s_music, fname, audio_device, s_music_buffer_ms);
+}
 
-    /* Load the .wav files from wherever the app is being run from. */
-    SDL_asprintf(&wav_path, "%s%s", SDL_GetBasePath(), fname);  /* allocate a string of the full file path */
-    if (!SDL_LoadWAV(wav_path, &spec, &sound->wav_data, &sound->wav_data_len)) {
-        SDL_Log("Couldn't load .wav file: %s", SDL_GetError());
+// Loader job: the sound effect whose SoundEffect is 'userdata'
+static bool load_effect(void *userdata) {
+    const SoundEffect sound = (SoundEffect) (intptr_t) userdata;
+    if (s_mixer.stream == NULL) {
         return false;
     }
+    if (s_has_bundle) {
+        return mixer_load_bundle(&s_mixer, sound, &s_bundle, EFFECT_FILES[sound]);
+    }
+    return mixer_load(&s_mixer, sound, EFFECT_FILES[sound]);
+}
+
+// Play 'sound' if it has finished loading
+static void play_effect(SoundEffect sound) {
+    if (loader_ready(&s_loader, s_effect_jobs[sound])) {
+        mixer_play(&s_mixer, sound);
+    }
+}
 
-    /* Create an audio stream. Set the source format to the wav's format (what
-       we'll input), leave the dest format NULL here (it'll change to what the
-       device wants once we bind it). */
-    sound->stream = SDL_CreateAudioStream(&spec, NULL);
-    if (!sound->stream) {
-        SDL_Log("Couldn't create audio stream: %s", SDL_GetError());
-    } else if (!SDL_BindAudioStream(audio_device, sound->stream)) {  /* once bound, it'll start playing when there is data available! */
-        SDL_Log("Failed to bind '%s' stream to device: %s", fname, SDL_GetError());
+// Pause or resume the audio device to match the AUDIO option, once the device is open
+static void apply_audio_option() {
+    if (!loader_ready(&s_loader, s_audio_job)) {
+        return;
+    }
+    if (is_audio_enabled == false) {
+        SDL_PauseAudioDevice(audio_device);
     } else {
-        retval = true;  /* success! */
+        SDL_ResumeAudioDevice(audio_device);
+    }
+    s_audio_option_applied = true;
+}
+
+// Switch to the FRAME RATE option; if the driver refuses it, show the mode still in use
+static void apply_pacing_option() {
+    if (!pacing_set_mode(&s_pacer, renderer, pacing_choice)) {
+        pacing_choice = s_pacer.mode;
+    }
+}
+
+static void note_presented_input(Uint64 timestamp_ns) {
+    if (s_presented_input_count < INPUT_QUEUE_SIZE) {
+        s_presented_inputs[s_presented_input_count++] = timestamp_ns;
+    }
+}
+
+// Queue a change of the arrow keys from an event at 'timestamp_ns'
+static void queue_input(Uint64 timestamp_ns, Directions direction) {
+    if (s_input_count == INPUT_QUEUE_SIZE) {
+        // Nothing has been simulated for a while (eg netplay waiting); apply the oldest now
+        s_input_direction = s_input_queue[s_input_first].direction;
+        s_input_first = (s_input_first + 1) % INPUT_QUEUE_SIZE;
+        s_input_count--;
+    }
+    InputEvent *input = &s_input_queue[(s_input_first + s_input_count) % INPUT_QUEUE_SIZE];
+    input->timestamp_ns = timestamp_ns;
+    input->direction = direction;
+    s_input_count++;
+}
+
+// Apply every queued change that happened before 'tick_end_ns'
+static void apply_inputs_until(Uint64 tick_end_ns) {
+    while (s_input_count > 0 && s_input_queue[s_input_first].timestamp_ns < tick_end_ns) {
+        s_input_direction = s_input_queue[s_input_first].direction;
+        note_presented_input(s_input_queue[s_input_first].timestamp_ns);
+        s_input_first = (s_input_first + 1) % INPUT_QUEUE_SIZE;
+        s_input_count--;
+    }
+}
+
+// Account a frame of stress mode that took 'work_ns' up to present, and grow the swarm
+static void stress_end_frame(Uint64 frame_end, Uint64 work_ns) {
+    s_stress_work_ns += work_ns;
+    s_stress_frames++;
+    if (s_stress_window_start == 0) {
+        s_stress_window_start = frame_end;
+    }
+    if (frame_end - s_stress_window_start < STRESS_WINDOW_NS || s_stress_ticks == 0) {
+        return;
+    }
+
+    const double tick_ms = (double) s_stress_swarm_ns / s_stress_ticks / SDL_NS_PER_MS;
+    const double frame_ms = (double) (s_stress_work_ns - s_stress_swarm_ns) / s_stress_frames / SDL_NS_PER_MS;
+    const double cost_60 = frame_ms + tick_ms * SIM_TICK_RATE / 60;
+    const double cost_144 = frame_ms + tick_ms * SIM_TICK_RATE / 144;
+    // Each count is judged on one window; once the ramp stops the swarm just keeps playing
+    if (s_stress_ramping) {
+        if (cost_60 <= 1000.0 / 60) {
+            s_stress_sustained_60 = s_swarm.count;
+        }
+        if (cost_144 <= 1000.0 / 144) {
+            s_stress_sustained_144 = s_swarm.count;
+        }
+        SDL_Log("Stress: %d balls, %.3f ms per tick, %.2f ms per frame at 60 fps, %.2f ms at 144 fps",
+                s_swarm.count, tick_ms, cost_60, cost_144);
+
+        if (cost_60 > 1000.0 / 60 || swarm_spawn(&s_swarm, SDL_max(s_swarm.count / 10, 64)) == 0) {
+            s_stress_ramping = false;
+            SDL_Log("Stress: sustained %d balls at 60 fps, %d at 144 fps", s_stress_sustained_60, s_stress_sustained_144);
+        }
+    }
+
+    s_stress_window_start = frame_end;
+    s_stress_swarm_ns = 0;
+    s_stress_ticks = 0;
+    s_stress_work_ns = 0;
+    s_stress_frames = 0;
+}
+
+static void report_loading() {
+    if (!s_loading_reported && loader_finished(&s_loader)) {
+        SDL_Log("Sounds loaded after %.1f ms", (double) (loader_finished_ns(&s_loader) - s_startup_ns) / SDL_NS_PER_MS);
+        s_loading_reported = true;
+    }
+}
+
+// Timeline action: the off or on half of the PLAY flash
+static void toggle_play_flash(void *userdata) {
+    s_show_play = !s_show_play;
+    s_redraw = true;
+}
+
+// Timeline cue: start.wav has played since PLAY was chosen
+static bool start_sound_finished(void *userdata) {
+    return mixer_finished(&s_mixer, SFX_START) != s_start_finished;
+}
+
+// Timeline action: leave the menu for the match
+static void start_game(void *userdata) {
+    const Uint64 now = SDL_GetTicksNS();
+    timeline_cancel(&s_timeline, s_play_flash);
+    s_show_play = true;
+    window_choice = GAME;
+    s_game_fade = 1;
+    timeline_tween(&s_timeline, now, &s_game_fade, 0, GAME_FADE_NS, EASE_OUT_CUBIC);
+}
+
+// How long an idle menu may wait for events before the timeline next needs a look
+static Sint32 menu_idle_timeout_ms(Uint64 now) {
+    const Uint64 due = timeline_next_due(&s_timeline, now);
+    if (due == 0) {
+        return MENU_IDLE_TIMEOUT_MS;
+    }
+    if (due <= now) {
+        return 0;
     }
+    return (Sint32) SDL_min((due - now + SDL_NS_PER_MS - 1) / SDL_NS_PER_MS, (Uint64) MENU_IDLE_TIMEOUT_MS);
+}
 
-    SDL_free(wav_path);  /* done with this string. */
-    return retval;
+// Snap interpolation to the current state, eg after a jump in a replay
+static void reset_interpolation() {
+    s_prev_position_player_y = s_match.position_player_y;
+    s_prev_position_cpu_y = s_match.position_cpu_y;
+    s_prev_position_ball_x = s_match.position_ball_x;
+    s_prev_position_ball_y = s_match.position_ball_y;
 }
 
 /* This function runs once at startup */
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
+    s_startup_ns = SDL_GetTicksNS();
     SDL_SetAppMetadata("Pong", "0.8", "gunz-sdl3-pong");
 
+    // Simulate matches without window or audio device and exit
+    if (headless_requested(argc, argv)) {
+        return headless_run(argc, argv);
+    }
+    if (tournament_requested(argc, argv)) {
+        return tournament_run(argc, argv);
+    }
+    if (capture_requested(argc, argv)) {
+        return capture_run(argc, argv);
+    }
+    trace_thread_name("main");
+
+    s_seed = SDL_GetPerformanceCounter();
+    overlay_init(&s_overlay);
+    timeline_init(&s_timeline);
+    if (!particles_create(&s_particles, PARTICLES_MAX, s_seed)) {
+        SDL_Log("Couldn't allocate %d particles", PARTICLES_MAX);
+        return SDL_APP_FAILURE;
+    }
+    if (!parse_game_options(argc, argv)) {
+        return SDL_APP_FAILURE;
+    }
+
+    if (s_replaying) {
+        // The replay brings its own seed and difficulty
+        if (!replay_reader_seek(&s_replay, 0, &s_match)) {
+            return SDL_APP_FAILURE;
+        }
+        SDL_Log("Replaying %.1f s match, seed %" SDL_PRIu64, replay_reader_duration(&s_replay), s_replay.seed);
+    } else {
+        MatchConfig config;
+        match_default_config(&config);
+        config.ball_speed_multiplier = ball_speed_multiplier;
+        config.paddle_speed_multiplier = paddle_speed_multiplier;
+        match_set_cpu_level(&config, cpu_level);
+        match_init(&s_match, &config, s_seed);
+        SDL_Log("Match seed %" SDL_PRIu64, s_seed);
+    }
+    reset_interpolation();
+
+    if (s_netplay) {
+        const bool opened = s_net_address != NULL ?
+            net_connect(&s_net, s_net_address, &s_net_conditions) :
+            net_host(&s_net, s_net_port, s_seed, &s_match.config, &s_net_conditions);
+        if (!opened) {
+            return SDL_APP_FAILURE;
+        }
+        // Straight into the match; the host's difficulty applies to both sides
+        window_choice = GAME;
+    }
+
+    if (s_stress_balls > 0) {
+        if (!swarm_create(&s_swarm, STRESS_MAX_BALLS, s_seed)) {
+            SDL_Log("Couldn't allocate %d balls", STRESS_MAX_BALLS);
+            return SDL_APP_FAILURE;
+        }
+        swarm_spawn(&s_swarm, s_stress_balls);
+        window_choice = GAME;
+    }
+
     // We will use this renderer to draw into this window every frame
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
         SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
@@ -138,41 +566,36 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
     /* Set a device-independent resolution and presentation mode for rendering. */
     SDL_SetRenderLogicalPresentation(renderer, GAME_WIDTH, GAME_HEIGHT, SDL_LOGICAL_PRESENTATION_LETTERBOX);
 
-    /* open the default audio device in whatever format it prefers; our audio streams will adjust to it. */
-    audio_device = SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, NULL);
-    if (audio_device == 0) {
-        SDL_Log("Couldn't open audio device: %s", SDL_GetError());
+    pacing_init(&s_pacer);
+    apply_pacing_option();
+
+    if (!scene_init()) {
         return SDL_APP_FAILURE;
     }
 
+    // Menu sounds first, as they're the first to be needed; the music only once GAME starts
+    loader_init(&s_loader);
+    s_audio_job = loader_add(&s_loader, "audio device", load_audio, NULL);
+    s_effect_jobs[SFX_MENU_SELECT] = loader_add(&s_loader, "menu_select.wav", load_effect, (void *) (intptr_t) SFX_MENU_SELECT);
+    s_effect_jobs[SFX_START] = loader_add(&s_loader, "start.wav", load_effect, (void *) (intptr_t) SFX_START);
+    s_effect_jobs[SFX_SCORE] = loader_add(&s_loader, "score.wav", load_effect, (void *) (intptr_t) SFX_SCORE);
+
     // Used to randomly select background music out of 4 tracks
     int random_music_number = SDL_rand(100);
+    const char *music_file;
 
     if (random_music_number < 25) {
-        if (!init_sound("bgm.wav", &sounds[0])) {
-            return SDL_APP_FAILURE;
-        }
+        music_file = "bgm.wav";
     } else if (random_music_number < 50) {
-        if (!init_sound("bgm2.wav", &sounds[0])) {
-            return SDL_APP_FAILURE;
-        }
+        music_file = "bgm2.wav";
     } else if (random_music_number < 75) {
-        if (!init_sound("bgm3.wav", &sounds[0])) {
-            return SDL_APP_FAILURE;
-        }
+        music_file = "bgm3.wav";
     } else {
-        if (!init_sound("bgm4.wav", &sounds[0])) {
-            return SDL_APP_FAILURE;
-        }
+        music_file = "bgm4.wav";
     }
+    s_music_job = loader_add(&s_loader, music_file, load_music, (void *) music_file);
 
-    if (!init_sound("score.wav", &sounds[1])) {
-        return SDL_APP_FAILURE;
-    }
-    if (!init_sound("menu_select.wav", &sounds[2])) {
-        return SDL_APP_FAILURE;
-    }
-    if (!init_sound("start.wav", &sounds[3])) {
+    if (!loader_start(&s_loader)) {
         return SDL_APP_FAILURE;
     }
 
@@ -181,16 +604,50 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
 
 /* This function runs when a new event (mouse input, keypresses, etc) occurs. */
 SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
+    const Uint64 event_start = SDL_GetTicksNS();
+    TRACE_ZONE("SDL_AppEvent");
+
+    // Anything reaching here may change what a menu shows, including window exposure
+    s_redraw = true;
+
+    // Cached menu textures lose their contents with the render targets
+    if (event->type == SDL_EVENT_RENDER_TARGETS_RESET || event->type == SDL_EVENT_RENDER_DEVICE_RESET) {
+        scene_invalidate();
+    }
+
+    // Frame-time overlay works on every screen
+    if (event->type == SDL_EVENT_KEY_DOWN && event->key.scancode == SDL_SCANCODE_F3 && event->key.repeat == false) {
+        s_overlay.visible = !s_overlay.visible;
+    }
+    if (event->type == SDL_EVENT_KEY_DOWN && event->key.scancode == SDL_SCANCODE_F4 && event->key.repeat == false) {
+        trace_dump(s_trace_path);
+    }
+
     switch (window_choice) {
         case GAME:
-            // For when key is pressed
-            if (event->type == SDL_EVENT_KEY_DOWN) {
+            // A replay supplies the player input; the arrow keys jump around in it instead
+            if (s_replaying) {
+                if (event->type == SDL_EVENT_KEY_DOWN &&
+                        (event->key.scancode == SDL_SCANCODE_LEFT || event->key.scancode == SDL_SCANCODE_RIGHT)) {
+                    const int jump = (int) (REPLAY_SEEK_SECONDS * s_replay.tick_rate);
+                    int tick = (int) s_replay.tick + (event->key.scancode == SDL_SCANCODE_LEFT ? -jump : jump);
+                    if (!replay_reader_seek(&s_replay, (Uint32) SDL_max(tick, 0), &s_match)) {
+                        return SDL_APP_FAILURE;
+                    }
+                    reset_interpolation();
+                    particles_clear(&s_particles);
+                }
+                break;
+            }
+
+            // For when key is pressed; key repeats change nothing
+            if (event->type == SDL_EVENT_KEY_DOWN && event->key.repeat == false) {
                 // Up key pressed
                 if (event->key.scancode == SDL_SCANCODE_UP) {
-                    s_direction_player = UP;
+                    queue_input(event->key.timestamp, UP);
                 // Down key pressed
                 } else if (event->key.scancode == SDL_SCANCODE_DOWN) {
-                    s_direction_player = DOWN;
+                    queue_input(event->key.timestamp, DOWN);
                 }
             }
 
@@ -198,25 +655,23 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
             if (event->type == SDL_EVENT_KEY_UP) {
                 // Up key released
                 if (event->key.scancode == SDL_SCANCODE_UP) {
-                    s_direction_player = ZERO;
+                    queue_input(event->key.timestamp, ZERO);
                 // Down key released
                 } else if (event->key.scancode == SDL_SCANCODE_DOWN) {
-                    s_direction_player = ZERO;
+                    queue_input(event->key.timestamp, ZERO);
                 }
             }
             break;
         
         case MAIN:
-            if (event->type == SDL_EVENT_KEY_DOWN && event->key.repeat == false && play_timer == 0) {
+            if (event->type == SDL_EVENT_KEY_DOWN && event->key.repeat == false && s_play_flash < 0) {
                 if (event->key.scancode == SDL_SCANCODE_DOWN) {
-                    SDL_ClearAudioStream(sounds[2].stream);
-                    SDL_PutAudioStreamData(sounds[2].stream, sounds[2].wav_data, (int) sounds[2].wav_data_len);
+                    play_effect(SFX_MENU_SELECT);
                     menu_choice = static_cast<Menu>((menu_choice + 1) % (QUIT+1));
                 }
 
                 if (event->key.scancode == SDL_SCANCODE_UP) {
-                    SDL_ClearAudioStream(sounds[2].stream);
-                    SDL_PutAudioStreamData(sounds[2].stream, sounds[2].wav_data, (int) sounds[2].wav_data_len);
+                    play_effect(SFX_MENU_SELECT);
                     if (menu_choice == 0) {
                         menu_choice = QUIT;
                     } else {
@@ -226,9 +681,12 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
                 
                 if (event->key.scancode == SDL_SCANCODE_RETURN) {
                     if (menu_choice == PLAY) {
-                        SDL_ClearAudioStream(sounds[3].stream);
-                        SDL_PutAudioStreamData(sounds[3].stream, sounds[3].wav_data, (int) sounds[3].wav_data_len);
-                        play_timer = 501760;    // The stream data of sounds[3]
+                        const Uint64 now = SDL_GetTicksNS();
+                        s_start_finished = mixer_finished(&s_mixer, SFX_START);
+                        play_effect(SFX_START);
+                        s_show_play = false;
+                        s_play_flash = timeline_every(&s_timeline, now, PLAY_FLASH_PERIOD_NS, toggle_play_flash, NULL);
+                        timeline_on_cue(&s_timeline, now, start_sound_finished, START_SOUND_NS, start_game, NULL);
                     } else if (menu_choice == OPTIONS) {
                         window_choice = CONFIG;
                     } else if (menu_choice == QUIT) {
@@ -241,14 +699,12 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
         case CONFIG:
             if (event->type == SDL_EVENT_KEY_DOWN && event->key.repeat == false) {
                 if (event->key.scancode == SDL_SCANCODE_DOWN) {
-                    SDL_ClearAudioStream(sounds[2].stream);
-                    SDL_PutAudioStreamData(sounds[2].stream, sounds[2].wav_data, (int) sounds[2].wav_data_len);
+                    play_effect(SFX_MENU_SELECT);
                     options_choice = static_cast<Option>((options_choice + 1) % (BACK+1));
                 }
 
                 if (event->key.scancode == SDL_SCANCODE_UP) {
-                    SDL_ClearAudioStream(sounds[2].stream);
-                    SDL_PutAudioStreamData(sounds[2].stream, sounds[2].wav_data, (int) sounds[2].wav_data_len);
+                    play_effect(SFX_MENU_SELECT);
                     if (options_choice == 0) {
                         options_choice = BACK;
                     } else {
@@ -262,6 +718,16 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
                     } else if (event->key.scancode == SDL_SCANCODE_RIGHT && is_fullscreen == true) {
                         is_fullscreen = false;
                     }
+                } else if (options_choice == PACING) {
+                    if (event->key.scancode == SDL_SCANCODE_LEFT) {
+                        if (pacing_choice == 0) {
+                            pacing_choice = F_CAP_144;
+                        } else {
+                            pacing_choice = static_cast<FramePacing>((pacing_choice - 1) % (F_CAP_144+1));
+                        }
+                    } else if (event->key.scancode == SDL_SCANCODE_RIGHT) {
+                        pacing_choice = static_cast<FramePacing>((pacing_choice + 1) % (F_CAP_144+1));
+                    }
                 } else if (options_choice == RESOLUTION) {
                     if (event->key.scancode == SDL_SCANCODE_LEFT) {
                         if (resolution_choice == 0) {
@@ -298,6 +764,16 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
                     } else if (event->key.scancode == SDL_SCANCODE_RIGHT) {
                         paddle_speed_difficulty = static_cast<PaddleSpeed>((paddle_speed_difficulty + 1) % (P_HIGH+1));
                     }
+                } else if (options_choice == CPU_LEVEL) {
+                    if (event->key.scancode == SDL_SCANCODE_LEFT) {
+                        if (cpu_level == 0) {
+                            cpu_level = C_HIGH;
+                        } else {
+                            cpu_level = static_cast<CpuLevel>((cpu_level - 1) % (C_HIGH+1));
+                        }
+                    } else if (event->key.scancode == SDL_SCANCODE_RIGHT) {
+                        cpu_level = static_cast<CpuLevel>((cpu_level + 1) % (C_HIGH+1));
+                    }
                 }
                 
                 if (event->key.scancode == SDL_SCANCODE_RETURN) {
@@ -330,11 +806,8 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
                         }
                         SDL_SetWindowSize(window, WINDOW_WIDTH, WINDOW_HEIGHT);
 
-                        if (is_audio_enabled == false) {
-                            SDL_PauseAudioStreamDevice(sounds->stream);
-                        } else {
-                            SDL_ResumeAudioStreamDevice(sounds->stream);
-                        }
+                        apply_pacing_option();
+                        apply_audio_option();
 
                         if (ball_speed_difficulty == B_LOW) {
                             ball_speed_multiplier = 0.3;
@@ -351,6 +824,13 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
                         } else if (paddle_speed_difficulty == P_HIGH) {
                             paddle_speed_multiplier = 1.0;
                         }
+
+                        // A replay keeps the difficulty it was recorded with
+                        if (!s_replaying) {
+                            s_match.config.ball_speed_multiplier = ball_speed_multiplier;
+                            s_match.config.paddle_speed_multiplier = paddle_speed_multiplier;
+                            match_set_cpu_level(&s_match.config, cpu_level);
+                        }
                     } else if (options_choice == BACK) {
                         window_choice = MAIN;
                     }
@@ -362,6 +842,8 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
             SDL_Log("Invalid window choice!");
     }
 
+    overlay_add_phase(&s_overlay, FRAME_PHASE_EVENTS, SDL_GetTicksNS() - event_start);
+
     if (event->type == SDL_EVENT_QUIT) {
         return SDL_APP_SUCCESS;  /* end the program, reporting success to the OS. */
     }
@@ -370,389 +852,179 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
 
 /* This function runs once per frame, and is the heart of the program. */
 SDL_AppResult SDL_AppIterate(void *appstate) {
-    // Tick play_timer down once it starts
-    if (play_timer > 0) {
-        play_timer -= 30;
+    const Uint64 frame_start = SDL_GetTicksNS();
+    Uint64 simulation_ns = 0;
+
+    // The device may have opened after the AUDIO option was changed
+    if (!s_audio_option_applied) {
+        apply_audio_option();
     }
 
-    // When timer starts, perform action when reaches certain threshold
-    if (play_timer > 0 && play_timer < 1000) {
-        window_choice = GAME;
+    // The PLAY flash, the switch to GAME and its fade in
+    timeline_update(&s_timeline, frame_start);
+
+    // A menu that is already on screen waits for the next event, or for the timeline
+    if (window_choice != GAME && !s_redraw && !s_overlay.visible) {
+        SDL_WaitEventTimeout(NULL, menu_idle_timeout_ms(frame_start));
+        last_time_ns = SDL_GetTicksNS();
+        report_loading();
+        return SDL_APP_CONTINUE;
     }
+    s_redraw = false;
+    TRACE_ZONE("SDL_AppIterate");
 
-    /* Get the number of milliseconds that have elapsed since the SDL library initialization */
-    const Uint64 now = SDL_GetTicks();
-    const float deltatime = ((float) (now - last_time)) / 1000.0f;
+    /* Seconds since the last frame. The simulation catches up to frame_start; its ticks
+       are placed back from there. */
+    const float deltatime = (float) (frame_start - last_time_ns) / SDL_NS_PER_SECOND;
 
     switch (window_choice) {
         case MAIN:
-            SDL_SetRenderDrawColor(renderer, 0, 32, 63, SDL_ALPHA_OPAQUE);
-            SDL_RenderClear(renderer);
-
-            SDL_SetRenderDrawColor(renderer, 173, 239, 209, SDL_ALPHA_OPAQUE);
-            SDL_SetRenderScale(renderer, 4.0f, 4.0f);
-            SDL_RenderDebugText(renderer, GAME_WIDTH/12, GAME_HEIGHT/15, "PONG");
-
-            SDL_SetRenderDrawColor(renderer, 173, 239, 209, SDL_ALPHA_OPAQUE);
-            SDL_SetRenderScale(renderer, 2.0f, 2.0f);
-            if (play_timer == 0 ||
-                    (play_timer > 0 && (now / 250) % 2 == 0)) {
-                SDL_RenderDebugText(renderer, GAME_WIDTH/5, GAME_HEIGHT/5, "PLAY");
-            }
-            SDL_RenderDebugText(renderer, GAME_WIDTH/5, GAME_HEIGHT/5+15, "OPTIONS");
-            SDL_RenderDebugText(renderer, GAME_WIDTH/5, GAME_HEIGHT/5+30, "QUIT");
-
-            SDL_SetRenderDrawColor(renderer, 214, 237, 23, SDL_ALPHA_OPAQUE);
-            if (menu_choice == PLAY) {
-                if (play_timer == 0 ||
-                        (play_timer > 0 && (now / 250) % 2 == 0)) {
-                    SDL_RenderDebugText(renderer, GAME_WIDTH/5, GAME_HEIGHT/5, "PLAY");
-                }
-            } else if (menu_choice == OPTIONS) {
-                SDL_RenderDebugText(renderer, GAME_WIDTH/5, GAME_HEIGHT/5+15, "OPTIONS");
-            } else if (menu_choice == QUIT) {
-                SDL_RenderDebugText(renderer, GAME_WIDTH/5, GAME_HEIGHT/5+30, "QUIT");
-            }
+            scene_render_main(renderer, menu_choice, s_show_play);
             break;
-        
+
         case CONFIG:
-            SDL_FRect fullscreen_choice;
-            fullscreen_choice.w = 4;
-            fullscreen_choice.h = 4;
-
-            SDL_FRect audio_choice;
-            audio_choice.w = 4;
-            audio_choice.h = 4;
-
-            SDL_FRect ball_speed_choice;
-            ball_speed_choice.w = 4;
-            ball_speed_choice.h = 4;
-
-            SDL_FRect paddle_speed_choice;
-            paddle_speed_choice.w = 4;
-            paddle_speed_choice.h = 4;
-
-            SDL_SetRenderDrawColor(renderer, 0, 32, 63, SDL_ALPHA_OPAQUE);
-            SDL_RenderClear(renderer);
-
-            SDL_SetRenderDrawColor(renderer, 173, 239, 209, SDL_ALPHA_OPAQUE);
-            SDL_SetRenderScale(renderer, 2.0f, 2.0f);
-            SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5-15, "Resolution");
-            if (resolution_choice == VGA) {
-                SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "640x480");
-            } else if (resolution_choice == SVGA) {
-                SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "800x600");
-            } else if (resolution_choice == HD) {
-                SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1280x720");
-            } else if (resolution_choice == XGA) {
-                SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1024x768");
-            } else if (resolution_choice == WXGA) {
-                SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1366x768");
-            } else if (resolution_choice == SXGA) {
-                SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "12801024");
-            } else if (resolution_choice == FHD) {
-                SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1920x1080");
-            } else if (resolution_choice == QHD) {
-                SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "2560x1440");
-            }
+        {
+            const ConfigView view = {options_choice, resolution_choice, is_fullscreen, pacing_choice, is_audio_enabled,
+                                     ball_speed_difficulty, paddle_speed_difficulty, cpu_level};
+            scene_render_config(renderer, &view);
+        }
+        break;
 
-            SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5, "Fullscreen");
-            SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5, "ON");
-            SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5, "OFF");
-            if (is_fullscreen == true) {
-                fullscreen_choice.x = 7*GAME_WIDTH/20 - 5;
-                fullscreen_choice.y = GAME_HEIGHT/5;
-            } else {
-                fullscreen_choice.x = 8*GAME_WIDTH/20 - 5;
-                fullscreen_choice.y = GAME_HEIGHT/5;
+        // Braces added for this case to prevent 'jump to case label' errors
+        case GAME:
+        {
+            // Keep the music's ring buffer topped up once it has loaded; it loops by itself
+            if (loader_ready(&s_loader, s_music_job)) {
+                music_update(&s_music);
             }
 
-            SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+15, "Audio");
-            SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+15, "ON");
-            SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+15, "OFF");
-            if (is_audio_enabled == true) {
-                audio_choice.x = 7*GAME_WIDTH/20 - 5;
-                audio_choice.y = GAME_HEIGHT/5+15;
-            } else {
-                audio_choice.x = 8*GAME_WIDTH/20 - 5;
-                audio_choice.y = GAME_HEIGHT/5+15;
-            }
-            
-            SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+30, "Ball Speed");
-            SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+30, "LOW");
-            SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+30, "MED");
-            SDL_RenderDebugText(renderer, 9*GAME_WIDTH/20, GAME_HEIGHT/5+30, "HIGH");
-            if (ball_speed_difficulty == B_LOW) {
-                ball_speed_choice.x = 7*GAME_WIDTH/20 - 5;
-                ball_speed_choice.y = GAME_HEIGHT/5+30;
-            } else if (ball_speed_difficulty == B_MEDIUM) {
-                ball_speed_choice.x = 8*GAME_WIDTH/20 - 5;
-                ball_speed_choice.y = GAME_HEIGHT/5+30;
-            } else if (ball_speed_difficulty == B_HIGH) {
-                ball_speed_choice.x = 9*GAME_WIDTH/20 - 5;
-                ball_speed_choice.y = GAME_HEIGHT/5+30;
+            // Start recording on the first frame of play, once the options are final
+            if (s_record_path != NULL) {
+                replay_writer_open(&s_recording, s_record_path, &s_match, s_seed);
+                s_record_path = NULL;
             }
 
-            SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+45, "Paddle Speed");
-            SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+45, "LOW");
-            SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+45, "MED");
-            SDL_RenderDebugText(renderer, 9*GAME_WIDTH/20, GAME_HEIGHT/5+45, "HIGH");
-            if (paddle_speed_difficulty == P_LOW) {
-                paddle_speed_choice.x = 7*GAME_WIDTH/20 - 5;
-                paddle_speed_choice.y = GAME_HEIGHT/5+45;
-            } else if (paddle_speed_difficulty == P_MEDIUM) {
-                paddle_speed_choice.x = 8*GAME_WIDTH/20 - 5;
-                paddle_speed_choice.y = GAME_HEIGHT/5+45;
-            } else if (paddle_speed_difficulty == P_HIGH) {
-                paddle_speed_choice.x = 9*GAME_WIDTH/20 - 5;
-                paddle_speed_choice.y = GAME_HEIGHT/5+45;
+            // The peer's inputs may have arrived and rewritten the last few ticks
+            const Uint64 simulation_start = SDL_GetTicksNS();
+            if (s_netplay && net_poll(&s_net, &s_match)) {
+                reset_interpolation();
             }
 
-            SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+70, "APPLY");
-            SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+80, "BACK");
-
-            SDL_RenderFillRect(renderer, &fullscreen_choice);
-            SDL_RenderFillRect(renderer, &audio_choice);
-            SDL_RenderFillRect(renderer, &ball_speed_choice);
-            SDL_RenderFillRect(renderer, &paddle_speed_choice);
-
-            SDL_SetRenderDrawColor(renderer, 214, 237, 23, SDL_ALPHA_OPAQUE);
-            if (options_choice == RESOLUTION) {
-                SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5-15, "Resolution");
-                if (resolution_choice == VGA) {
-                    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "640x480");
-                } else if (resolution_choice == SVGA) {
-                    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "800x600");
-                } else if (resolution_choice == HD) {
-                    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1280x720");
-                } else if (resolution_choice == XGA) {
-                    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1024x768");
-                } else if (resolution_choice == WXGA) {
-                    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1366x768");
-                } else if (resolution_choice == SXGA) {
-                    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "12801024");
-                } else if (resolution_choice == FHD) {
-                    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1920x1080");
-                } else if (resolution_choice == QHD) {
-                    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "2560x1440");
+            // Run as many fixed ticks as the elapsed time covers, but never more than SIM_MAX_SUBSTEPS
+            sim_accumulator += deltatime;
+            int substeps = 0;
+            while (sim_accumulator >= SIM_DT && substeps < SIM_MAX_SUBSTEPS) {
+                s_prev_position_player_y = s_match.position_player_y;
+                s_prev_position_cpu_y = s_match.position_cpu_y;
+                s_prev_position_ball_x = s_match.position_ball_x;
+                s_prev_position_ball_y = s_match.position_ball_y;
+
+                if (s_replaying && !replay_reader_advance(&s_replay, &s_match)) {
+                    SDL_Log("Replay finished, %d desynced keyframes", s_replay.desyncs);
+                    return SDL_APP_SUCCESS;
                 }
 
-            } else if (options_choice == FULLSCREEN) {
-                SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5, "Fullscreen");
-                SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5, "ON");
-                SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5, "OFF");
-                if (is_fullscreen == true) {
-                    fullscreen_choice.x = 7*GAME_WIDTH/20 - 5;
-                    fullscreen_choice.y = GAME_HEIGHT/5;
+                // This tick stands for the SIM_DT of wall time ending here; keys pressed in it count from it
+                const Uint64 tick_end_ns = frame_start - (Uint64) ((sim_accumulator - SIM_DT) * SDL_NS_PER_SECOND);
+                apply_inputs_until(tick_end_ns);
+
+                int events;
+                if (s_netplay) {
+                    // The host plays the left paddle, the client the right one
+                    Directions direction = s_input_direction;
+                    if (s_autoplay) {
+                        Match mirrored = s_match;
+                        if (!s_net.host) {
+                            mirrored.position_player_y = s_match.position_cpu_y;
+                        }
+                        direction = match_autoplay_direction(&mirrored);
+                    }
+                    events = net_advance(&s_net, &s_match, direction);
+                    if (events < 0) {
+                        // Waiting for the peer; nothing moved this frame
+                        reset_interpolation();
+                        sim_accumulator = 0;
+                        break;
+                    }
                 } else {
-                    fullscreen_choice.x = 8*GAME_WIDTH/20 - 5;
-                    fullscreen_choice.y = GAME_HEIGHT/5;
+                    if (!s_replaying) {
+                        s_match.direction_player = s_autoplay ? match_autoplay_direction(&s_match) : s_input_direction;
+                    }
+                    if (s_recording.io) {
+                        replay_writer_tick(&s_recording, &s_match);
+                    }
+                    events = match_step(&s_match, SIM_DT);
                 }
-
-            } else if (options_choice == AUDIO) {
-                SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+15, "Audio");
-                SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+15, "ON");
-                SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+15, "OFF");
-                if (is_audio_enabled == true) {
-                    audio_choice.x = 7*GAME_WIDTH/20 - 5;
-                    audio_choice.y = GAME_HEIGHT/5+15;
-                } else {
-                    audio_choice.x = 8*GAME_WIDTH/20 - 5;
-                    audio_choice.y = GAME_HEIGHT/5+15;
+                if (s_stress_balls > 0) {
+                    const Uint64 swarm_start = SDL_GetTicksNS();
+                    swarm_step(&s_swarm, &s_match, SIM_DT);
+                    s_stress_swarm_ns += SDL_GetTicksNS() - swarm_start;
+                    s_stress_ticks++;
                 }
-
-            } else if (options_choice == BALL_SPEED) {
-                SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+30, "Ball Speed");
-                SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+30, "LOW");
-                SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+30, "MED");
-                SDL_RenderDebugText(renderer, 9*GAME_WIDTH/20, GAME_HEIGHT/5+30, "HIGH");
-                if (ball_speed_difficulty == B_LOW) {
-                    ball_speed_choice.x = 7*GAME_WIDTH/20 - 5;
-                    ball_speed_choice.y = GAME_HEIGHT/5+30;
-                } else if (ball_speed_difficulty == B_MEDIUM) {
-                    ball_speed_choice.x = 8*GAME_WIDTH/20 - 5;
-                    ball_speed_choice.y = GAME_HEIGHT/5+30;
-                } else if (ball_speed_difficulty == B_HIGH) {
-                    ball_speed_choice.x = 9*GAME_WIDTH/20 - 5;
-                    ball_speed_choice.y = GAME_HEIGHT/5+30;
+                const float ball_center_y = s_match.position_ball_y + BALL_SIZE/2;
+                if (events & MATCH_EVENT_HIT_PLAYER) {
+                    emit_particles(&SPARKS, 0, PADDLE_PLAYER_X + PADDLE_WIDTH, ball_center_y);
                 }
-
-            } else if (options_choice == PADDLE_SPEED) {
-                SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+45, "Paddle Speed");
-                SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+45, "LOW");
-                SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+45, "MED");
-                SDL_RenderDebugText(renderer, 9*GAME_WIDTH/20, GAME_HEIGHT/5+45, "HIGH");
-                if (paddle_speed_difficulty == P_LOW) {
-                    paddle_speed_choice.x = 7*GAME_WIDTH/20 - 5;
-                    paddle_speed_choice.y = GAME_HEIGHT/5+45;
-                } else if (paddle_speed_difficulty == P_MEDIUM) {
-                    paddle_speed_choice.x = 8*GAME_WIDTH/20 - 5;
-                    paddle_speed_choice.y = GAME_HEIGHT/5+45;
-                } else if (paddle_speed_difficulty == P_HIGH) {
-                    paddle_speed_choice.x = 9*GAME_WIDTH/20 - 5;
-                    paddle_speed_choice.y = GAME_HEIGHT/5+45;
+                if (events & MATCH_EVENT_HIT_CPU) {
+                    emit_particles(&SPARKS, SDL_PI_F, PADDLE_CPU_X, ball_center_y);
                 }
-
-            } else if (options_choice == APPLY) {
-                SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+70, "APPLY");
-
-            } else if (options_choice == BACK) {
-                SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+80, "BACK");
-            }
-            break;
-        
-        // Braces added for this case to prevent 'jump to case label' errors
-        case GAME:
-        {
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
-            SDL_RenderClear(renderer);
-            SDL_SetRenderDrawColor(renderer, 242, 170, 76, SDL_ALPHA_OPAQUE);
-            SDL_SetRenderScale(renderer, 1.0f, 1.0f);
-
-            /* If less than a full copy of the audio is queued for playback, put another copy in there.
-                This is overkill, but easy when lots of RAM is cheap. One could be more careful and
-                queue less at a time, as long as the stream doesn't run dry.  */
-            if (SDL_GetAudioStreamQueued(sounds[0].stream) < ((int) sounds[0].wav_data_len)) {
-                SDL_PutAudioStreamData(sounds[0].stream, sounds[0].wav_data, (int) sounds[0].wav_data_len);
-            }
-            
-            SDL_FRect background;
-            SDL_FRect paddle_player;
-            SDL_FRect paddle_cpu;
-            SDL_FRect ball;
-
-            // Background covering only viewport and not entire screen
-            background.x = 0;
-            background.y = 0;
-            background.w = GAME_WIDTH;
-            background.h = GAME_HEIGHT;
-
-            // Left edge of screen
-            paddle_player.x = 5;
-            paddle_player.y = s_position_player_y;
-            paddle_player.w = 10;
-            paddle_player.h = 60;
-
-
-            // Right edge of screen
-            paddle_cpu.x = GAME_WIDTH - 15;
-            paddle_cpu.y = s_position_cpu_y;
-            paddle_cpu.w = 10;
-            paddle_cpu.h = 60;
-
-            // Top and bottom of each paddles to assist in ball collisions
-            float paddle_player_top = paddle_player.y + 4;
-            float paddle_player_bottom = paddle_player_top + paddle_player.h - 4;
-            float paddle_cpu_top = paddle_cpu.y + 4;
-            float paddle_cpu_bottom = paddle_cpu_top + paddle_cpu.h - 4;
-
-            // Bound player to screen if exceeding window limit, else move player paddle
-            if (s_position_player_y < 0) {
-                s_position_player_y = 0;
-            } else if (s_position_player_y > GAME_HEIGHT-paddle_player.h) {
-                s_position_player_y = GAME_HEIGHT-paddle_player.h;
-            } else {
-                s_position_player_y -= 300*s_direction_player*deltatime*paddle_speed_multiplier;
-            }
-
-            // Move CPU vertically in ping-pong motion
-            s_position_cpu_y -= 250*s_direction_cpu*deltatime*paddle_speed_multiplier;
-            if (s_position_cpu_y < 0) {
-                s_direction_cpu = DOWN;
-            }
-            
-            if (s_position_cpu_y > GAME_HEIGHT-paddle_cpu.h) {
-                s_direction_cpu = UP;
-            }
-
-            ball.x = s_position_ball_x;
-            ball.y = s_position_ball_y;
-            ball.w = 10;
-            ball.h = 10;
-
-            // Reset x component to prevent ball getting stuck in one dimension
-            if (s_component_ball_x < 0.3 or s_component_ball_x > 0.7) {
-                s_component_ball_x = SDL_randf();
-            }
-            float s_component_ball_y = 1 - s_component_ball_x;
-
-            s_position_ball_x -= 400*s_direction_ball_x*s_component_ball_x*deltatime*ball_speed_multiplier;
-            s_position_ball_y -= 400*s_direction_ball_y*s_component_ball_y*deltatime*ball_speed_multiplier;
-
-            // Handling ball collision with player
-            if (s_position_ball_x <= paddle_player.x + paddle_player.w) {
-                if (s_position_ball_y > paddle_player_top && s_position_ball_y < paddle_player_bottom) {
-                    s_direction_ball_x = DOWN;
-                    // Change direction of ball to direction of paddle
-                    if (s_direction_player == UP) {
-                        s_direction_ball_y = UP;
-                    } else if (s_direction_player == DOWN) {
-                        s_direction_ball_y = DOWN;
-                    }
+                // Goals burst back into the court from where the ball left it
+                if (events & MATCH_EVENT_SCORE_PLAYER) {
+                    emit_particles(&GOAL_BURST, SDL_PI_F, GAME_WIDTH, s_prev_position_ball_y + BALL_SIZE/2);
                 }
-            }
-
-            // Handling ball collision with CPU
-            if (s_position_ball_x >= paddle_cpu.x - paddle_cpu.w) {
-                if (s_position_ball_y > paddle_cpu_top && s_position_ball_y < paddle_cpu_bottom) {
-                    s_direction_ball_x = UP;
-                    // Change direction of ball to direction of paddle
-                    if (s_direction_cpu == UP) {
-                        s_direction_ball_y = UP;
-                    } else if (s_direction_cpu == DOWN) {
-                        s_direction_ball_y = DOWN;
-                    }
+                if (events & MATCH_EVENT_SCORE_CPU) {
+                    emit_particles(&GOAL_BURST, 0, 0, s_prev_position_ball_y + BALL_SIZE/2);
                 }
+                if (events & (MATCH_EVENT_SCORE_PLAYER | MATCH_EVENT_SCORE_CPU)) {
+                    play_effect(SFX_SCORE);
+                    // Ball was served from the centre; don't interpolate across the screen
+                    s_prev_position_ball_x = s_match.position_ball_x;
+                    s_prev_position_ball_y = s_match.position_ball_y;
+                } else {
+                    particles_emit(&s_particles, &BALL_TRAIL, s_match.position_ball_x + BALL_SIZE/2, ball_center_y);
+                }
+                sim_accumulator -= SIM_DT;
+                substeps++;
             }
-
-            // Handling collision with top and bottom wall respectively
-            if (s_position_ball_y <= 0) {
-                s_direction_ball_y = DOWN;
+            // Too far behind (eg window drag); drop the backlog instead of spiralling
+            if (sim_accumulator >= SIM_DT) {
+                sim_accumulator = 0;
             }
-            if (s_position_ball_y >= GAME_HEIGHT) {
-                s_direction_ball_y = UP;
+            if (s_netplay) {
+                net_flush(&s_net);
             }
-
-            // When ball crosses left or right side of screen and someone scores
-            if (s_position_ball_x < -20) {
-                s_position_ball_x = GAME_WIDTH/2;
-                s_position_ball_y = SDL_rand(GAME_HEIGHT);
-                s_component_ball_x = SDL_randf();
-                s_direction_ball_x = UP;
-                SDL_PutAudioStreamData(sounds[1].stream, sounds[1].wav_data, (int) sounds[1].wav_data_len);
-                s_score_cpu++;
+            particles_update(&s_particles, deltatime);
+            const Uint64 simulation_end = SDL_GetTicksNS();
+            simulation_ns = simulation_end - simulation_start;
+            TRACE_SPAN("GAME update", simulation_start, simulation_end);
+
+            // How far we are between the previous and the current tick
+            const float alpha = sim_accumulator / SIM_DT;
+
+            GameView view;
+            view.position_player_y = s_prev_position_player_y + (s_match.position_player_y - s_prev_position_player_y) * alpha;
+            view.position_cpu_y = s_prev_position_cpu_y + (s_match.position_cpu_y - s_prev_position_cpu_y) * alpha;
+            view.position_ball_x = s_prev_position_ball_x + (s_match.position_ball_x - s_prev_position_ball_x) * alpha;
+            view.position_ball_y = s_prev_position_ball_y + (s_match.position_ball_y - s_prev_position_ball_y) * alpha;
+            view.score_player = s_match.score_player;
+            view.score_cpu = s_match.score_cpu;
+            scene_render_game(renderer, &view);
+            if (s_stress_balls > 0) {
+                swarm_draw(&s_swarm, renderer);
             }
-
-            if (s_position_ball_x > GAME_WIDTH + 10) {
-                s_position_ball_x = GAME_WIDTH/2;
-                s_position_ball_y = SDL_rand(GAME_HEIGHT);
-                s_component_ball_x = SDL_randf();
-                s_direction_ball_x = UP;
-                SDL_PutAudioStreamData(sounds[1].stream, sounds[1].wav_data, (int) sounds[1].wav_data_len);
-                s_score_player++;
+            particles_draw(&s_particles, renderer);
+
+            if (s_game_fade > 0) {
+                const SDL_FRect screen = {0, 0, GAME_WIDTH, GAME_HEIGHT};
+                SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+                SDL_SetRenderDrawColor(renderer, 0, 0, 0, (Uint8) (s_game_fade * 255));
+                SDL_RenderFillRect(renderer, &screen);
+                SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
             }
 
-            SDL_SetRenderDrawColor(renderer, 16, 24, 32, SDL_ALPHA_OPAQUE);
-            SDL_RenderFillRect(renderer, &background);
-
-            // Rendering paddles and ball
-            SDL_SetRenderDrawColor(renderer, 242, 170, 76, SDL_ALPHA_OPAQUE);
-            SDL_RenderFillRect(renderer, &paddle_player);
-            SDL_RenderFillRect(renderer, &paddle_cpu);
-
-            SDL_SetRenderDrawColor(renderer, 233, 75, 60, SDL_ALPHA_OPAQUE);
-            SDL_RenderFillRect(renderer, &ball);
-
-            // Display scores
-            SDL_SetRenderScale(renderer, 1.0f, 1.0f);
-            SDL_SetRenderDrawColor(renderer, 151, 188, 98, SDL_ALPHA_OPAQUE);
-            SDL_RenderDebugTextFormat(renderer, GAME_WIDTH/4, 100, "%d", s_score_player);
-            SDL_RenderDebugTextFormat(renderer, 3*GAME_WIDTH/4, 100, "%d", s_score_cpu);
-
-            // Middle partition
-            SDL_SetRenderDrawColor(renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
-            for (int i = 0; i < GAME_HEIGHT; i += 10) {
-                SDL_RenderPoint(renderer, GAME_WIDTH/2, i);
+            if (s_netplay && !s_net.started) {
+                SDL_SetRenderDrawColor(renderer, 173, 239, 209, SDL_ALPHA_OPAQUE);
+                SDL_RenderDebugText(renderer, GAME_WIDTH/2 - 80, GAME_HEIGHT/2 - 40, "Waiting for opponent");
             }
         }
         break;
@@ -761,24 +1033,69 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
             SDL_Log("Invalid window choice!");
     }
 
-    last_time = now;
+    overlay_draw(&s_overlay, renderer);
+
+    last_time_ns = frame_start;
+    const Uint64 present_start = SDL_GetTicksNS();
     SDL_RenderPresent(renderer);  /* put it all on the screen! */
+    const Uint64 frame_end = SDL_GetTicksNS();
+    TRACE_SPAN("SDL_RenderPresent", present_start, frame_end);
+
+    // Latency probe: key changes simulated this frame are on screen now
+    for (int i = 0; i < s_presented_input_count; i++) {
+        overlay_add_input_latency(&s_overlay, frame_end - s_presented_inputs[i]);
+    }
+    s_presented_input_count = 0;
+
+    overlay_add_phase(&s_overlay, FRAME_PHASE_SIMULATION, simulation_ns);
+    overlay_add_phase(&s_overlay, FRAME_PHASE_RENDER, present_start - frame_start - simulation_ns);
+    overlay_add_phase(&s_overlay, FRAME_PHASE_PRESENT, frame_end - present_start);
+    overlay_end_frame(&s_overlay, frame_end);
+
+    if (s_stress_balls > 0 && window_choice == GAME) {
+        stress_end_frame(frame_end, present_start - frame_start);
+    }
+
+    if (!s_first_frame_reported) {
+        SDL_Log("First frame after %.1f ms", (double) (frame_end - s_startup_ns) / SDL_NS_PER_MS);
+        s_first_frame_reported = true;
+    }
+    report_loading();
+
+    pacing_wait(&s_pacer);
     return SDL_APP_CONTINUE;  /* carry on with the program! */
 }
 
 /* This function runs once at shutdown. */
 void SDL_AppQuit(void *appstate, SDL_AppResult result)
 {
-    int i;
-    for (i = 0; i < SDL_arraysize(sounds); i++) {
-        /* If less than a full copy of the audio is queued for playback, put another copy in there.
-           This is overkill, but easy when lots of RAM is cheap. One could be more careful and
-           queue less at a time, as long as the stream doesn't run dry.  */
-        if (SDL_GetAudioStreamQueued(sounds[i].stream) < ((int) sounds[i].wav_data_len)) {
-            SDL_PutAudioStreamData(sounds[i].stream, sounds[i].wav_data, (int) sounds[i].wav_data_len);
-        }
+    if (s_recording.io) {
+        replay_writer_close(&s_recording);
+    }
+    replay_reader_close(&s_replay);
+    if (s_frame_csv_path != NULL) {
+        overlay_write_csv(&s_overlay, s_frame_csv_path);
+    }
+    overlay_log_input_latency(&s_overlay);
+    pacing_log(&s_pacer);
+
+    if (s_netplay) {
+        net_close(&s_net);
     }
+    if (s_stress_balls > 0) {
+        SDL_Log("Stress: sustained %d balls at 60 fps, %d at 144 fps; %" SDL_PRIu64 " ball and %" SDL_PRIu64 " paddle bounces",
+                s_stress_sustained_60, s_stress_sustained_144, s_swarm.ball_hits, s_swarm.paddle_hits);
+        swarm_destroy(&s_swarm);
+    }
+
+    particles_destroy(&s_particles);
+
+    loader_finish(&s_loader);
+    music_close(&s_music);
+    mixer_close(&s_mixer);
+    bundle_close(&s_bundle);
     
+    scene_quit();
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
 
@@ -0,0 +1,267 @@
+#include "pong_env.h"
+#include "match.h"
+#include "batch.h"
+
+enum EnvJobType {
+    ENV_JOB_RESET,
+    ENV_JOB_STEP,
+    ENV_JOB_QUIT
+};
+
+typedef struct EnvJob {
+    EnvJobType type;
+    const int32_t *actions;
+    float *observations;
+    float *rewards;
+    uint8_t *dones;
+} EnvJob;
+
+// A worker's matches. Own cache line each, so workers never share a written one.
+struct alignas(64) EnvSlice {
+    PongEnv *env;
+    int first;              // Index of the slice's first match
+    MatchBatch batch;
+    int *steps;             // Into the current episode
+    Uint64 *episodes;       // Started so far, to seed the next one
+    float *rewards;         // Summed over the ticks of a step
+    SDL_Thread *thread;     // NULL for slice 0, which the calling thread steps
+    SDL_Semaphore *start;
+};
+
+struct PongEnv {
+    PongEnvConfig config;
+    MatchConfig match_config;
+    BatchIsa isa;
+    EnvSlice *slices;
+    int slice_count;
+    SDL_Semaphore *finished;    // Signalled by each worker when it has done the job
+    EnvJob job;                 // Written before the workers are started on it
+};
+
+void pong_env_default_config(PongEnvConfig *config) {
+    MatchConfig match_config;
+    match_default_config(&match_config);
+    config->num_envs = 1;
+    config->num_threads = 0;
+    config->seed = 1;
+    config->ticks_per_step = 4;
+    config->points = 11;
+    config->max_steps = 0;
+    config->ball_speed_multiplier = match_config.ball_speed_multiplier;
+    config->paddle_speed_multiplier = match_config.paddle_speed_multiplier;
+    config->cpu_speed = match_config.cpu_speed;
+}
+
+static void reset_match(PongEnv *env, EnvSlice *slice, int index) {
+    const Uint64 seed = match_seed(match_seed(env->config.seed, slice->first + index), slice->episodes[index]++);
+    Match match;
+    match_init(&match, &env->match_config, seed);
+    batch_set_match(&slice->batch, index, &match);
+    slice->steps[index] = 0;
+}
+
+static void write_observation(const MatchBatch *batch, int index, float *out) {
+    out[0] = (batch->position_ball_x[index] + BALL_SIZE/2) / GAME_WIDTH;
+    out[1] = (batch->position_ball_y[index] + BALL_SIZE/2) / GAME_HEIGHT;
+    // A direction of UP (1) moves towards smaller coordinates
+    out[2] = -batch->direction_ball_x[index] * batch->component_ball_x[index];
+    out[3] = -batch->direction_ball_y[index] * (1 - batch->component_ball_x[index]);
+    out[4] = (batch->position_player_y[index] + PADDLE_HEIGHT/2) / GAME_HEIGHT;
+    out[5] = (batch->position_cpu_y[index] + PADDLE_HEIGHT/2) / GAME_HEIGHT;
+    out[6] = (float) batch->score_player[index];
+    out[7] = (float) batch->score_cpu[index];
+}
+
+static void reset_slice(PongEnv *env, EnvSlice *slice) {
+    for (int i = 0; i < slice->batch.count; i++) {
+        reset_match(env, slice, i);
+        if (env->job.observations) {
+            write_observation(&slice->batch, i, env->job.observations + (size_t) (slice->first + i) * PONG_ENV_OBS_SIZE);
+        }
+    }
+}
+
+static void step_slice(PongEnv *env, EnvSlice *slice) {
+    MatchBatch *batch = &slice->batch;
+    const EnvJob *job = &env->job;
+
+    for (int i = 0; i < batch->count; i++) {
+        const int32_t action = job->actions[slice->first + i];
+        batch->direction_player[i] = action == PONG_ENV_UP ? UP : (action == PONG_ENV_DOWN ? DOWN : ZERO);
+        slice->rewards[i] = 0;
+    }
+
+    for (int tick = 0; tick < env->config.ticks_per_step; tick++) {
+        batch_step(batch, SIM_DT, env->isa);
+        for (int i = 0; i < batch->count; i++) {
+            const int events = batch->events[i];
+            slice->rewards[i] += ((events & MATCH_EVENT_SCORE_PLAYER) ? 1.0f : 0.0f) -
+                                 ((events & MATCH_EVENT_SCORE_CPU) ? 1.0f : 0.0f);
+        }
+    }
+
+    for (int i = 0; i < batch->count; i++) {
+        const int index = slice->first + i;
+        uint8_t done = 0;
+        slice->steps[i]++;
+        if (batch->score_player[i] >= env->config.points || batch->score_cpu[i] >= env->config.points) {
+            done = PONG_ENV_TERMINATED;
+        } else if (env->config.max_steps > 0 && slice->steps[i] >= env->config.max_steps) {
+            done = PONG_ENV_TRUNCATED;
+        }
+        if (done) {
+            reset_match(env, slice, i);
+        }
+
+        if (job->rewards) {
+            job->rewards[index] = slice->rewards[i];
+        }
+        if (job->dones) {
+            job->dones[index] = done;
+        }
+        if (job->observations) {
+            write_observation(batch, i, job->observations + (size_t) index * PONG_ENV_OBS_SIZE);
+        }
+    }
+}
+
+static void run_slice(PongEnv *env, EnvSlice *slice) {
+    if (env->job.type == ENV_JOB_RESET) {
+        reset_slice(env, slice);
+    } else if (env->job.type == ENV_JOB_STEP) {
+        step_slice(env, slice);
+    }
+}
+
+static int SDLCALL worker_main(void *data) {
+    EnvSlice *slice = (EnvSlice *) data;
+    PongEnv *env = slice->env;
+    for (;;) {
+        SDL_WaitSemaphore(slice->start);
+        if (env->job.type == ENV_JOB_QUIT) {
+            break;
+        }
+        run_slice(env, slice);
+        SDL_SignalSemaphore(env->finished);
+    }
+    return 0;
+}
+
+// Run env->job on every slice, slice 0 on this thread, and wait for all of them
+static void run_job(PongEnv *env) {
+    for (int s = 1; s < env->slice_count; s++) {
+        SDL_SignalSemaphore(env->slices[s].start);
+    }
+    run_slice(env, &env->slices[0]);
+    for (int s = 1; s < env->slice_count; s++) {
+        SDL_WaitSemaphore(env->finished);
+    }
+}
+
+void pong_env_destroy(PongEnv *env) {
+    if (!env) {
+        return;
+    }
+    env->job.type = ENV_JOB_QUIT;
+    for (int s = 0; s < env->slice_count; s++) {
+        EnvSlice *slice = &env->slices[s];
+        if (slice->thread) {
+            SDL_SignalSemaphore(slice->start);
+            SDL_WaitThread(slice->thread, NULL);
+        }
+        SDL_DestroySemaphore(slice->start);
+        batch_destroy(&slice->batch);
+        SDL_free(slice->steps);
+        SDL_free(slice->episodes);
+        SDL_free(slice->rewards);
+    }
+    SDL_aligned_free(env->slices);
+    SDL_DestroySemaphore(env->finished);
+    SDL_free(env);
+}
+
+PongEnv *pong_env_create(const PongEnvConfig *config) {
+    if (config->num_envs <= 0 || config->num_threads < 0 || config->ticks_per_step <= 0 ||
+        config->points <= 0 || config->max_steps < 0) {
+        SDL_Log("Invalid PongEnvConfig");
+        return NULL;
+    }
+
+    PongEnv *env = (PongEnv *) SDL_calloc(1, sizeof(PongEnv));
+    if (!env) {
+        return NULL;
+    }
+    env->config = *config;
+    match_default_config(&env->match_config);
+    env->match_config.ball_speed_multiplier = config->ball_speed_multiplier;
+    env->match_config.paddle_speed_multiplier = config->paddle_speed_multiplier;
+    env->match_config.cpu_speed = config->cpu_speed;
+    env->isa = batch_best_isa();
+
+    // Whole vectors per slice; fewer, fuller slices if there aren't enough matches to go round
+    const int threads = config->num_threads > 0 ? config->num_threads : SDL_max(SDL_GetNumLogicalCPUCores(), 1);
+    int slice_size = (config->num_envs + threads - 1) / threads;
+    slice_size = ((slice_size + BATCH_MAX_WIDTH - 1) / BATCH_MAX_WIDTH) * BATCH_MAX_WIDTH;
+    const int slice_count = (config->num_envs + slice_size - 1) / slice_size;
+
+    env->slices = (EnvSlice *) SDL_aligned_alloc(alignof(EnvSlice), slice_count * sizeof(EnvSlice));
+    env->finished = SDL_CreateSemaphore(0);
+    if (!env->slices || !env->finished) {
+        pong_env_destroy(env);
+        return NULL;
+    }
+    SDL_memset(env->slices, 0, slice_count * sizeof(EnvSlice));
+
+    for (int s = 0; s < slice_count; s++) {
+        EnvSlice *slice = &env->slices[s];
+        const int first = s * slice_size;
+        const int count = SDL_min(slice_size, config->num_envs - first);
+        env->slice_count++;
+        slice->env = env;
+        slice->first = first;
+        slice->steps = (int *) SDL_calloc(count, sizeof(int));
+        slice->episodes = (Uint64 *) SDL_calloc(count, sizeof(Uint64));
+        slice->rewards = (float *) SDL_calloc(count, sizeof(float));
+        slice->start = SDL_CreateSemaphore(0);
+        if (!batch_create(&slice->batch, count) || !slice->steps || !slice->episodes || !slice->rewards || !slice->start) {
+            pong_env_destroy(env);
+            return NULL;
+        }
+        if (s > 0) {
+            slice->thread = SDL_CreateThread(worker_main, "pong_env", slice);
+            if (!slice->thread) {
+                SDL_Log("Couldn't start env worker: %s", SDL_GetError());
+                pong_env_destroy(env);
+                return NULL;
+            }
+        }
+    }
+
+    // Start every match, so stepping before any reset is well defined
+    env->job.type = ENV_JOB_RESET;
+    env->job.observations = NULL;
+    run_job(env);
+    return env;
+}
+
+int32_t pong_env_num_envs(const PongEnv *env) {
+    return env->config.num_envs;
+}
+
+void pong_env_reset(PongEnv *env, float *observations) {
+    env->job.type = ENV_JOB_RESET;
+    env->job.actions = NULL;
+    env->job.observations = observations;
+    env->job.rewards = NULL;
+    env->job.dones = NULL;
+    run_job(env);
+}
+
+void pong_env_step(PongEnv *env, const int32_t *actions, float *observations, float *rewards, uint8_t *dones) {
+    env->job.type = ENV_JOB_STEP;
+    env->job.actions = actions;
+    env->job.observations = observations;
+    env->job.rewards = rewards;
+    env->job.dones = dones;
+    run_job(env);
+}
@@ -0,0 +1,89 @@
+/* Vectorised training environment: N Pong matches stepped together, with the left paddle
+ * driven by an action per match and the right one by the ping-pong CPU. A plain C
+ * interface over the batch kernel (batch.h), for loading from Python (ctypes/cffi) or
+ * any other language with a C FFI. No window, renderer or audio device is used.
+ *
+ * Observations, rewards and done flags are written straight into arrays the caller owns,
+ * observation k of match i at observations[i * PONG_ENV_OBS_SIZE + k]:
+ *   0, 1  ball centre x and y, over the court's width and height (0 to 1)
+ *   2, 3  ball direction: share of its speed along x (+ is right) and along y (+ is down)
+ *   4     left paddle centre y, over the court's height
+ *   5     right paddle centre y, over the court's height
+ *   6, 7  left and right score
+ *
+ * Matches run on a pool of worker threads, each owning a fixed slice of them, so a step
+ * allocates nothing and never locks beyond handing the slices out and collecting them.
+ */
+
+#ifndef PONG_ENV_H
+#define PONG_ENV_H
+
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(PONG_ENV_BUILD)
+#define PONG_ENV_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define PONG_ENV_API __declspec(dllimport)
+#else
+#define PONG_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    PONG_ENV_OBS_SIZE = 8
+};
+
+// Actions for the left paddle
+enum {
+    PONG_ENV_STAY = 0,
+    PONG_ENV_UP = 1,
+    PONG_ENV_DOWN = 2
+};
+
+// Bits of a done flag
+enum {
+    PONG_ENV_TERMINATED = 1,    // One side reached 'points'
+    PONG_ENV_TRUNCATED = 2      // Ran 'max_steps' steps without that
+};
+
+typedef struct PongEnvConfig {
+    int32_t num_envs;
+    int32_t num_threads;        // 0 for one per CPU core
+    uint64_t seed;              // Match i's episodes are seeded from this and i alone
+    int32_t ticks_per_step;     // Game ticks (1/240 s each) an action is held for
+    int32_t points;             // A match ends when either side has this many
+    int32_t max_steps;          // and is cut short after this many steps; 0 for never
+    float ball_speed_multiplier;
+    float paddle_speed_multiplier;
+    float cpu_speed;            // Right paddle speed in px/s before paddle_speed_multiplier
+} PongEnvConfig;
+
+typedef struct PongEnv PongEnv;
+
+// The game's MEDIUM settings, 4 ticks per step (60 decisions a second) and 11 points
+PONG_ENV_API void pong_env_default_config(PongEnvConfig *config);
+
+// NULL if the config is invalid or the matches or threads couldn't be set up
+PONG_ENV_API PongEnv *pong_env_create(const PongEnvConfig *config);
+PONG_ENV_API void pong_env_destroy(PongEnv *env);
+
+PONG_ENV_API int32_t pong_env_num_envs(const PongEnv *env);
+
+// Start a new episode in every match and write their first observations
+PONG_ENV_API void pong_env_reset(PongEnv *env, float *observations);
+
+/* Hold actions[i] (a PONG_ENV_ action) in match i for ticks_per_step ticks. rewards[i] is
+ * +1 for each point the left paddle won in that time and -1 for each it lost. A match
+ * that finished gets its dones[i] bits set and is reset at once: observations[i] is then
+ * the first observation of its next episode. Any of the output arrays may be NULL. */
+PONG_ENV_API void pong_env_step(PongEnv *env, const int32_t *actions, float *observations,
+                                float *rewards, uint8_t *dones);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,334 @@
+#include "replay.h"
+
+static const Uint32 REPLAY_MAGIC = 0x4C505250;     // "PRPL"
+static const Uint32 REPLAY_VERSION = 2;
+
+static const Uint8 RECORD_KEYFRAME = 'K';
+static const Uint8 RECORD_INPUT = 'I';
+
+// Where the fields filled in on close live in the header
+static const Sint64 HEADER_TICK_COUNT_OFFSET = 24;
+static const Sint64 HEADER_SIZE = 44;
+
+static bool write_float(SDL_IOStream *io, float value) {
+    Uint32 bits;
+    SDL_memcpy(&bits, &value, sizeof(bits));
+    return SDL_WriteU32LE(io, bits);
+}
+
+static bool read_float(SDL_IOStream *io, float *value) {
+    Uint32 bits;
+    if (!SDL_ReadU32LE(io, &bits)) {
+        return false;
+    }
+    SDL_memcpy(value, &bits, sizeof(bits));
+    return true;
+}
+
+static bool write_match(SDL_IOStream *io, const Match *match) {
+    return write_float(io, match->config.ball_speed_multiplier) &&
+           write_float(io, match->config.paddle_speed_multiplier) &&
+           write_float(io, match->config.cpu_speed) &&
+           SDL_WriteU8(io, (Uint8) match->config.cpu_control) &&
+           write_float(io, match->config.cpu_reaction) &&
+           write_float(io, match->config.cpu_error) &&
+           write_float(io, match->position_player_y) &&
+           write_float(io, match->position_cpu_y) &&
+           write_float(io, match->position_ball_x) &&
+           write_float(io, match->position_ball_y) &&
+           write_float(io, match->component_ball_x) &&
+           SDL_WriteS8(io, (Sint8) match->direction_player) &&
+           SDL_WriteS8(io, (Sint8) match->direction_cpu) &&
+           SDL_WriteS8(io, (Sint8) match->direction_ball_x) &&
+           SDL_WriteS8(io, (Sint8) match->direction_ball_y) &&
+           SDL_WriteU32LE(io, (Uint32) match->score_player) &&
+           SDL_WriteU32LE(io, (Uint32) match->score_cpu) &&
+           write_float(io, match->cpu_target_y) &&
+           write_float(io, match->cpu_think_time) &&
+           SDL_WriteU64LE(io, match->rng_state);
+}
+
+static bool read_direction(SDL_IOStream *io, Directions *direction) {
+    Sint8 value;
+    if (!SDL_ReadS8(io, &value) || value < DOWN || value > UP) {
+        return false;
+    }
+    *direction = (Directions) value;
+    return true;
+}
+
+static bool read_match(SDL_IOStream *io, Match *match) {
+    Uint32 score_player, score_cpu;
+    Uint8 cpu_control;
+    if (!(read_float(io, &match->config.ball_speed_multiplier) &&
+          read_float(io, &match->config.paddle_speed_multiplier) &&
+          read_float(io, &match->config.cpu_speed) &&
+          SDL_ReadU8(io, &cpu_control) &&
+          read_float(io, &match->config.cpu_reaction) &&
+          read_float(io, &match->config.cpu_error) &&
+          read_float(io, &match->position_player_y) &&
+          read_float(io, &match->position_cpu_y) &&
+          read_float(io, &match->position_ball_x) &&
+          read_float(io, &match->position_ball_y) &&
+          read_float(io, &match->component_ball_x) &&
+          read_direction(io, &match->direction_player) &&
+          read_direction(io, &match->direction_cpu) &&
+          read_direction(io, &match->direction_ball_x) &&
+          read_direction(io, &match->direction_ball_y) &&
+          SDL_ReadU32LE(io, &score_player) &&
+          SDL_ReadU32LE(io, &score_cpu) &&
+          read_float(io, &match->cpu_target_y) &&
+          read_float(io, &match->cpu_think_time) &&
+          SDL_ReadU64LE(io, &match->rng_state))) {
+        return false;
+    }
+    // Replays are of single-player matches
+    if (cpu_control != CPU_PING_PONG && cpu_control != CPU_PREDICT) {
+        return false;
+    }
+    match->config.cpu_control = (CpuControl) cpu_control;
+    match->score_player = (int) score_player;
+    match->score_cpu = (int) score_cpu;
+    return true;
+}
+
+static bool same_state(const Match *a, const Match *b) {
+    return a->config.ball_speed_multiplier == b->config.ball_speed_multiplier &&
+           a->config.paddle_speed_multiplier == b->config.paddle_speed_multiplier &&
+           a->config.cpu_speed == b->config.cpu_speed &&
+           a->config.cpu_control == b->config.cpu_control &&
+           a->config.cpu_reaction == b->config.cpu_reaction &&
+           a->config.cpu_error == b->config.cpu_error &&
+           a->cpu_target_y == b->cpu_target_y &&
+           a->cpu_think_time == b->cpu_think_time &&
+           a->position_player_y == b->position_player_y &&
+           a->position_cpu_y == b->position_cpu_y &&
+           a->position_ball_x == b->position_ball_x &&
+           a->position_ball_y == b->position_ball_y &&
+           a->component_ball_x == b->component_ball_x &&
+           a->direction_cpu == b->direction_cpu &&
+           a->direction_ball_x == b->direction_ball_x &&
+           a->direction_ball_y == b->direction_ball_y &&
+           a->score_player == b->score_player &&
+           a->score_cpu == b->score_cpu &&
+           a->rng_state == b->rng_state;
+}
+
+static bool write_keyframe(ReplayWriter *writer, const Match *match) {
+    if (writer->keyframe_count == writer->keyframe_capacity) {
+        Uint32 capacity = SDL_max(writer->keyframe_capacity * 2, 64u);
+        Uint64 *offsets = (Uint64 *) SDL_realloc(writer->keyframe_offsets, capacity * sizeof(Uint64));
+        if (!offsets) {
+            return false;
+        }
+        writer->keyframe_offsets = offsets;
+        writer->keyframe_capacity = capacity;
+    }
+
+    const Sint64 offset = SDL_TellIO(writer->io);
+    if (offset < 0) {
+        return false;
+    }
+    writer->keyframe_offsets[writer->keyframe_count++] = (Uint64) offset;
+    return SDL_WriteU8(writer->io, RECORD_KEYFRAME) &&
+           SDL_WriteU32LE(writer->io, writer->tick) &&
+           write_match(writer->io, match);
+}
+
+bool replay_writer_open(ReplayWriter *writer, const char *path, const Match *match, Uint64 seed) {
+    SDL_zerop(writer);
+    writer->io = SDL_IOFromFile(path, "wb");
+    if (!writer->io) {
+        SDL_Log("Couldn't create replay '%s': %s", path, SDL_GetError());
+        return false;
+    }
+    writer->seed = seed;
+    writer->last_direction = match->direction_player;
+
+    // Tick count, index offset and keyframe count are placeholders until close
+    if (!(SDL_WriteU32LE(writer->io, REPLAY_MAGIC) &&
+          SDL_WriteU32LE(writer->io, REPLAY_VERSION) &&
+          SDL_WriteU32LE(writer->io, SIM_TICK_RATE) &&
+          SDL_WriteU32LE(writer->io, REPLAY_KEYFRAME_INTERVAL) &&
+          SDL_WriteU64LE(writer->io, seed) &&
+          SDL_WriteU32LE(writer->io, 0) &&
+          SDL_WriteU64LE(writer->io, 0) &&
+          SDL_WriteU32LE(writer->io, 0) &&
+          SDL_WriteU32LE(writer->io, 0))) {
+        SDL_Log("Couldn't write replay header: %s", SDL_GetError());
+        SDL_CloseIO(writer->io);
+        writer->io = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool replay_writer_tick(ReplayWriter *writer, const Match *match) {
+    if (!writer->io) {
+        return false;
+    }
+
+    // A keyframe carries the input too, so no input record is needed on its tick
+    bool ok;
+    if (writer->tick % REPLAY_KEYFRAME_INTERVAL == 0) {
+        ok = write_keyframe(writer, match);
+    } else if (match->direction_player != writer->last_direction) {
+        ok = SDL_WriteU8(writer->io, RECORD_INPUT) &&
+             SDL_WriteU32LE(writer->io, writer->tick) &&
+             SDL_WriteS8(writer->io, (Sint8) match->direction_player);
+    } else {
+        ok = true;
+    }
+    writer->last_direction = match->direction_player;
+    writer->tick++;
+
+    if (!ok) {
+        SDL_Log("Couldn't write replay, stopped recording: %s", SDL_GetError());
+        SDL_CloseIO(writer->io);
+        writer->io = NULL;
+        SDL_free(writer->keyframe_offsets);
+        writer->keyframe_offsets = NULL;
+    }
+    return ok;
+}
+
+bool replay_writer_close(ReplayWriter *writer) {
+    if (!writer->io) {
+        return false;
+    }
+
+    bool ok = true;
+    const Sint64 index_offset = SDL_TellIO(writer->io);
+    for (Uint32 i = 0; i < writer->keyframe_count && ok; i++) {
+        ok = SDL_WriteU64LE(writer->io, writer->keyframe_offsets[i]);
+    }
+    ok = ok && index_offset >= 0 &&
+         SDL_SeekIO(writer->io, HEADER_TICK_COUNT_OFFSET, SDL_IO_SEEK_SET) >= 0 &&
+         SDL_WriteU32LE(writer->io, writer->tick) &&
+         SDL_WriteU64LE(writer->io, (Uint64) index_offset) &&
+         SDL_WriteU32LE(writer->io, writer->keyframe_count);
+    if (!SDL_CloseIO(writer->io)) {
+        ok = false;
+    }
+    if (!ok) {
+        SDL_Log("Couldn't finish replay: %s", SDL_GetError());
+    }
+
+    SDL_free(writer->keyframe_offsets);
+    SDL_zerop(writer);
+    return ok;
+}
+
+bool replay_reader_open(ReplayReader *reader, const char *path) {
+    SDL_zerop(reader);
+    reader->io = SDL_IOFromFile(path, "rb");
+    if (!reader->io) {
+        SDL_Log("Couldn't open replay '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    Uint32 magic, version, reserved;
+    if (!(SDL_ReadU32LE(reader->io, &magic) &&
+          SDL_ReadU32LE(reader->io, &version) &&
+          SDL_ReadU32LE(reader->io, &reader->tick_rate) &&
+          SDL_ReadU32LE(reader->io, &reader->keyframe_interval) &&
+          SDL_ReadU64LE(reader->io, &reader->seed) &&
+          SDL_ReadU32LE(reader->io, &reader->tick_count) &&
+          SDL_ReadU64LE(reader->io, &reader->index_offset) &&
+          SDL_ReadU32LE(reader->io, &reader->keyframe_count) &&
+          SDL_ReadU32LE(reader->io, &reserved)) ||
+          magic != REPLAY_MAGIC || version != REPLAY_VERSION) {
+        SDL_Log("'%s' is not a replay", path);
+        replay_reader_close(reader);
+        return false;
+    }
+    if (reader->tick_rate == 0 || reader->keyframe_interval == 0 ||
+            reader->index_offset < (Uint64) HEADER_SIZE || reader->keyframe_count == 0) {
+        SDL_Log("Replay '%s' is unfinished or damaged", path);
+        replay_reader_close(reader);
+        return false;
+    }
+    return true;
+}
+
+void replay_reader_close(ReplayReader *reader) {
+    if (reader->io) {
+        SDL_CloseIO(reader->io);
+    }
+    SDL_zerop(reader);
+}
+
+float replay_reader_duration(const ReplayReader *reader) {
+    return (float) reader->tick_count / reader->tick_rate;
+}
+
+float replay_reader_dt(const ReplayReader *reader) {
+    return 1.0f / reader->tick_rate;
+}
+
+// Read the next record into the reader's look-ahead; false at the index or on error
+static bool read_record(ReplayReader *reader) {
+    reader->has_record = false;
+    if ((Uint64) SDL_TellIO(reader->io) >= reader->index_offset) {
+        return false;
+    }
+    if (!SDL_ReadU8(reader->io, &reader->record_type) || !SDL_ReadU32LE(reader->io, &reader->record_tick)) {
+        return false;
+    }
+    if (reader->record_type == RECORD_KEYFRAME) {
+        reader->has_record = read_match(reader->io, &reader->record_match);
+    } else if (reader->record_type == RECORD_INPUT) {
+        reader->has_record = read_direction(reader->io, &reader->record_direction);
+    }
+    return reader->has_record;
+}
+
+bool replay_reader_seek(ReplayReader *reader, Uint32 tick, Match *match) {
+    if (tick > reader->tick_count) {
+        tick = reader->tick_count;
+    }
+
+    // One index lookup, then at most one keyframe interval to re-simulate
+    Uint32 keyframe = SDL_min(tick / reader->keyframe_interval, reader->keyframe_count - 1);
+    Uint64 offset;
+    if (SDL_SeekIO(reader->io, (Sint64) (reader->index_offset + keyframe * sizeof(Uint64)), SDL_IO_SEEK_SET) < 0 ||
+            !SDL_ReadU64LE(reader->io, &offset) ||
+            SDL_SeekIO(reader->io, (Sint64) offset, SDL_IO_SEEK_SET) < 0 ||
+            !read_record(reader) || reader->record_type != RECORD_KEYFRAME) {
+        SDL_Log("Couldn't seek replay to tick %" SDL_PRIu32, tick);
+        return false;
+    }
+
+    *match = reader->record_match;
+    reader->tick = reader->record_tick;
+
+    const float dt = replay_reader_dt(reader);
+    while (reader->tick < tick) {
+        if (!replay_reader_advance(reader, match)) {
+            return false;
+        }
+        match_step(match, dt);
+    }
+    return true;
+}
+
+bool replay_reader_advance(ReplayReader *reader, Match *match) {
+    if (reader->tick >= reader->tick_count) {
+        return false;
+    }
+
+    while (reader->has_record && reader->record_tick <= reader->tick) {
+        if (reader->record_type == RECORD_KEYFRAME) {
+            if (!same_state(match, &reader->record_match)) {
+                reader->desyncs++;
+            }
+            match->direction_player = reader->record_match.direction_player;
+        } else {
+            match->direction_player = reader->record_direction;
+        }
+        read_record(reader);
+    }
+
+    reader->tick++;
+    return true;
+}
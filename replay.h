@@ -0,0 +1,78 @@
+/* Replays: the starting state of a match plus every change of player input, enough to
+ * re-simulate it exactly since match_step() is deterministic for a given seed.
+ *
+ * File layout, all values little-endian:
+ *   header    magic, version, tick rate, keyframe interval, seed, tick count,
+ *             index offset, keyframe count (the last three are filled in on close)
+ *   records   'K' tick match    full Match snapshot, every keyframe interval ticks
+ *             'I' tick dir      player input changed before this tick
+ *   index     file offset of each keyframe record
+ *
+ * Keyframe n is always at tick n * interval, so seeking looks up one index entry and
+ * re-simulates at most one interval. Files are read as a stream; only the header and
+ * the record being decoded are ever in memory.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <SDL3/SDL.h>
+#include "match.h"
+
+// Ticks between keyframes (one second of play)
+const Uint32 REPLAY_KEYFRAME_INTERVAL = SIM_TICK_RATE;
+
+typedef struct ReplayWriter {
+    SDL_IOStream *io;
+    Uint64 seed;
+    Uint32 tick;
+    Directions last_direction;
+    Uint64 *keyframe_offsets;
+    Uint32 keyframe_count;
+    Uint32 keyframe_capacity;
+} ReplayWriter;
+
+typedef struct ReplayReader {
+    SDL_IOStream *io;
+    Uint32 tick_rate;
+    Uint32 keyframe_interval;
+    Uint64 seed;
+    Uint32 tick_count;
+    Uint64 index_offset;
+    Uint32 keyframe_count;
+
+    Uint32 tick;            // Next tick advance will prepare
+    bool has_record;        // A record has been read ahead and not applied yet
+    Uint8 record_type;
+    Uint32 record_tick;
+    Directions record_direction;
+    Match record_match;
+    int desyncs;            // Keyframes that didn't match the re-simulated state
+} ReplayReader;
+
+// Start recording to 'path'; 'match' is the state before the first tick
+bool replay_writer_open(ReplayWriter *writer, const char *path, const Match *match, Uint64 seed);
+
+// Record 'match' (including its player input) as it is about to be stepped
+bool replay_writer_tick(ReplayWriter *writer, const Match *match);
+
+// Write the index and finish the file
+bool replay_writer_close(ReplayWriter *writer);
+
+bool replay_reader_open(ReplayReader *reader, const char *path);
+void replay_reader_close(ReplayReader *reader);
+
+// Length of the replay in seconds
+float replay_reader_duration(const ReplayReader *reader);
+
+// Seconds between ticks the replay was recorded with
+float replay_reader_dt(const ReplayReader *reader);
+
+// Put 'match' in its state before tick 'tick' (clamped to the replay's length)
+bool replay_reader_seek(ReplayReader *reader, Uint32 tick, Match *match);
+
+/* Set the player input of 'match' for the next tick, checking it against any keyframe
+ * on the way. Returns false at the end of the replay or on a read error. */
+bool replay_reader_advance(ReplayReader *reader, Match *match);
+
+#endif
@@ -0,0 +1,503 @@
+#include "scenes.h"
+#include "geometry.h"
+#include "trace.h"
+
+// Background, two paddles, ball and one quad per partition point
+static const int GAME_SCENE_QUADS = 4 + GAME_HEIGHT/10;
+
+static Geometry s_game_geometry;
+
+/* A menu drawn into its own texture, redrawn only when what it shows changes and
+   otherwise put on screen as a single textured quad */
+typedef struct MenuLayer {
+    SDL_Texture *texture;
+    bool valid;             // Texture holds the menu as described by the cached state
+} MenuLayer;
+
+static MenuLayer s_main_layer;
+static Menu s_main_menu_choice;
+static bool s_main_show_play;
+
+static MenuLayer s_config_layer;
+static ConfigView s_config_view;
+
+// Score HUD: digits 0-9 of the debug font rendered once into an atlas, and the quads
+// showing the current scores, rebuilt only when a score changes
+static const int HUD_GLYPH_SIZE = SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE;
+static const int HUD_MAX_DIGITS = 10;
+
+typedef struct ScoreHud {
+    SDL_Texture *atlas;
+    bool atlas_valid;
+    Geometry geometry;
+    bool geometry_valid;
+    int score_player;       // Scores the geometry shows
+    int score_cpu;
+} ScoreHud;
+
+static ScoreHud s_hud;
+
+bool scene_init(void) {
+    if (!geometry_create(&s_game_geometry, GAME_SCENE_QUADS) ||
+            !geometry_create(&s_hud.geometry, 2 * HUD_MAX_DIGITS)) {
+        SDL_Log("Couldn't allocate scene geometry");
+        return false;
+    }
+    return true;
+}
+
+void scene_quit(void) {
+    geometry_destroy(&s_game_geometry);
+    if (s_main_layer.texture) {
+        SDL_DestroyTexture(s_main_layer.texture);
+    }
+    if (s_config_layer.texture) {
+        SDL_DestroyTexture(s_config_layer.texture);
+    }
+    SDL_zero(s_main_layer);
+    SDL_zero(s_config_layer);
+
+    geometry_destroy(&s_hud.geometry);
+    if (s_hud.atlas) {
+        SDL_DestroyTexture(s_hud.atlas);
+    }
+    SDL_zero(s_hud);
+}
+
+void scene_invalidate(void) {
+    s_main_layer.valid = false;
+    s_config_layer.valid = false;
+    s_hud.atlas_valid = false;
+}
+
+static bool same_config_view(const ConfigView *a, const ConfigView *b) {
+    return a->options_choice == b->options_choice &&
+           a->resolution_choice == b->resolution_choice &&
+           a->is_fullscreen == b->is_fullscreen &&
+           a->frame_pacing == b->frame_pacing &&
+           a->is_audio_enabled == b->is_audio_enabled &&
+           a->ball_speed_difficulty == b->ball_speed_difficulty &&
+           a->paddle_speed_difficulty == b->paddle_speed_difficulty &&
+           a->cpu_level == b->cpu_level;
+}
+
+// Point rendering at the layer's texture, creating it on first use; false if targets aren't supported
+static bool begin_layer(SDL_Renderer *renderer, MenuLayer *layer, SDL_Texture **previous_target) {
+    if (!layer->texture) {
+        layer->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_XRGB8888, SDL_TEXTUREACCESS_TARGET,
+                                           GAME_WIDTH, GAME_HEIGHT);
+        if (!layer->texture) {
+            return false;
+        }
+        // The debug font is pixel art; keep it sharp when the layer is scaled up
+        SDL_SetTextureScaleMode(layer->texture, SDL_SCALEMODE_NEAREST);
+    }
+    *previous_target = SDL_GetRenderTarget(renderer);
+    return SDL_SetRenderTarget(renderer, layer->texture);
+}
+
+static void end_layer(SDL_Renderer *renderer, MenuLayer *layer, SDL_Texture *previous_target) {
+    SDL_SetRenderTarget(renderer, previous_target);
+    layer->valid = true;
+}
+
+static void blit_layer(SDL_Renderer *renderer, const MenuLayer *layer) {
+    const SDL_FRect screen = {0, 0, GAME_WIDTH, GAME_HEIGHT};
+    SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+    SDL_RenderTexture(renderer, layer->texture, NULL, &screen);
+}
+
+static void draw_main(SDL_Renderer *renderer, Menu menu_choice, bool show_play) {
+    TRACE_ZONE("menu text");
+    SDL_SetRenderDrawColor(renderer, 0, 32, 63, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(renderer);
+
+    SDL_SetRenderDrawColor(renderer, 173, 239, 209, SDL_ALPHA_OPAQUE);
+    SDL_SetRenderScale(renderer, 4.0f, 4.0f);
+    SDL_RenderDebugText(renderer, GAME_WIDTH/12, GAME_HEIGHT/15, "PONG");
+
+    SDL_SetRenderDrawColor(renderer, 173, 239, 209, SDL_ALPHA_OPAQUE);
+    SDL_SetRenderScale(renderer, 2.0f, 2.0f);
+    if (show_play) {
+        SDL_RenderDebugText(renderer, GAME_WIDTH/5, GAME_HEIGHT/5, "PLAY");
+    }
+    SDL_RenderDebugText(renderer, GAME_WIDTH/5, GAME_HEIGHT/5+15, "OPTIONS");
+    SDL_RenderDebugText(renderer, GAME_WIDTH/5, GAME_HEIGHT/5+30, "QUIT");
+
+    SDL_SetRenderDrawColor(renderer, 214, 237, 23, SDL_ALPHA_OPAQUE);
+    if (menu_choice == PLAY) {
+        if (show_play) {
+            SDL_RenderDebugText(renderer, GAME_WIDTH/5, GAME_HEIGHT/5, "PLAY");
+        }
+    } else if (menu_choice == OPTIONS) {
+        SDL_RenderDebugText(renderer, GAME_WIDTH/5, GAME_HEIGHT/5+15, "OPTIONS");
+    } else if (menu_choice == QUIT) {
+        SDL_RenderDebugText(renderer, GAME_WIDTH/5, GAME_HEIGHT/5+30, "QUIT");
+    }
+}
+
+static void draw_pacing_value(SDL_Renderer *renderer, FramePacing frame_pacing) {
+    if (frame_pacing == F_VSYNC) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+15, "VSYNC");
+    } else if (frame_pacing == F_ADAPTIVE) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+15, "ADAPTIVE");
+    } else if (frame_pacing == F_UNCAPPED) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+15, "UNCAPPED");
+    } else if (frame_pacing == F_CAP_30) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+15, "30 FPS");
+    } else if (frame_pacing == F_CAP_60) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+15, "60 FPS");
+    } else if (frame_pacing == F_CAP_144) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+15, "144 FPS");
+    }
+}
+
+static void draw_config(SDL_Renderer *renderer, const ConfigView *view) {
+    TRACE_ZONE("menu text");
+    SDL_FRect fullscreen_choice;
+    fullscreen_choice.w = 4;
+    fullscreen_choice.h = 4;
+
+    SDL_FRect audio_choice;
+    audio_choice.w = 4;
+    audio_choice.h = 4;
+
+    SDL_FRect ball_speed_choice;
+    ball_speed_choice.w = 4;
+    ball_speed_choice.h = 4;
+
+    SDL_FRect paddle_speed_choice;
+    paddle_speed_choice.w = 4;
+    paddle_speed_choice.h = 4;
+
+    SDL_FRect cpu_level_choice;
+    cpu_level_choice.w = 4;
+    cpu_level_choice.h = 4;
+
+    SDL_SetRenderDrawColor(renderer, 0, 32, 63, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(renderer);
+
+    SDL_SetRenderDrawColor(renderer, 173, 239, 209, SDL_ALPHA_OPAQUE);
+    SDL_SetRenderScale(renderer, 2.0f, 2.0f);
+    SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5-15, "Resolution");
+    if (view->resolution_choice == VGA) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "640x480");
+    } else if (view->resolution_choice == SVGA) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "800x600");
+    } else if (view->resolution_choice == HD) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1280x720");
+    } else if (view->resolution_choice == XGA) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1024x768");
+    } else if (view->resolution_choice == WXGA) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1366x768");
+    } else if (view->resolution_choice == SXGA) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "12801024");
+    } else if (view->resolution_choice == FHD) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1920x1080");
+    } else if (view->resolution_choice == QHD) {
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "2560x1440");
+    }
+
+    SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5, "Fullscreen");
+    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5, "ON");
+    SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5, "OFF");
+    if (view->is_fullscreen == true) {
+        fullscreen_choice.x = 7*GAME_WIDTH/20 - 5;
+        fullscreen_choice.y = GAME_HEIGHT/5;
+    } else {
+        fullscreen_choice.x = 8*GAME_WIDTH/20 - 5;
+        fullscreen_choice.y = GAME_HEIGHT/5;
+    }
+
+    SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+15, "Frame Rate");
+    draw_pacing_value(renderer, view->frame_pacing);
+
+    SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+30, "Audio");
+    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+30, "ON");
+    SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+30, "OFF");
+    if (view->is_audio_enabled == true) {
+        audio_choice.x = 7*GAME_WIDTH/20 - 5;
+        audio_choice.y = GAME_HEIGHT/5+30;
+    } else {
+        audio_choice.x = 8*GAME_WIDTH/20 - 5;
+        audio_choice.y = GAME_HEIGHT/5+30;
+    }
+    
+    SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+45, "Ball Speed");
+    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+45, "LOW");
+    SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+45, "MED");
+    SDL_RenderDebugText(renderer, 9*GAME_WIDTH/20, GAME_HEIGHT/5+45, "HIGH");
+    if (view->ball_speed_difficulty == B_LOW) {
+        ball_speed_choice.x = 7*GAME_WIDTH/20 - 5;
+        ball_speed_choice.y = GAME_HEIGHT/5+45;
+    } else if (view->ball_speed_difficulty == B_MEDIUM) {
+        ball_speed_choice.x = 8*GAME_WIDTH/20 - 5;
+        ball_speed_choice.y = GAME_HEIGHT/5+45;
+    } else if (view->ball_speed_difficulty == B_HIGH) {
+        ball_speed_choice.x = 9*GAME_WIDTH/20 - 5;
+        ball_speed_choice.y = GAME_HEIGHT/5+45;
+    }
+
+    SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+60, "Paddle Speed");
+    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+60, "LOW");
+    SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+60, "MED");
+    SDL_RenderDebugText(renderer, 9*GAME_WIDTH/20, GAME_HEIGHT/5+60, "HIGH");
+    if (view->paddle_speed_difficulty == P_LOW) {
+        paddle_speed_choice.x = 7*GAME_WIDTH/20 - 5;
+        paddle_speed_choice.y = GAME_HEIGHT/5+60;
+    } else if (view->paddle_speed_difficulty == P_MEDIUM) {
+        paddle_speed_choice.x = 8*GAME_WIDTH/20 - 5;
+        paddle_speed_choice.y = GAME_HEIGHT/5+60;
+    } else if (view->paddle_speed_difficulty == P_HIGH) {
+        paddle_speed_choice.x = 9*GAME_WIDTH/20 - 5;
+        paddle_speed_choice.y = GAME_HEIGHT/5+60;
+    }
+
+    SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+75, "CPU");
+    SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+75, "LOW");
+    SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+75, "MED");
+    SDL_RenderDebugText(renderer, 9*GAME_WIDTH/20, GAME_HEIGHT/5+75, "HIGH");
+    if (view->cpu_level == C_LOW) {
+        cpu_level_choice.x = 7*GAME_WIDTH/20 - 5;
+        cpu_level_choice.y = GAME_HEIGHT/5+75;
+    } else if (view->cpu_level == C_MEDIUM) {
+        cpu_level_choice.x = 8*GAME_WIDTH/20 - 5;
+        cpu_level_choice.y = GAME_HEIGHT/5+75;
+    } else if (view->cpu_level == C_HIGH) {
+        cpu_level_choice.x = 9*GAME_WIDTH/20 - 5;
+        cpu_level_choice.y = GAME_HEIGHT/5+75;
+    }
+
+    SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+90, "APPLY");
+    SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+100, "BACK");
+
+    SDL_RenderFillRect(renderer, &fullscreen_choice);
+    SDL_RenderFillRect(renderer, &audio_choice);
+    SDL_RenderFillRect(renderer, &ball_speed_choice);
+    SDL_RenderFillRect(renderer, &paddle_speed_choice);
+    SDL_RenderFillRect(renderer, &cpu_level_choice);
+
+    SDL_SetRenderDrawColor(renderer, 214, 237, 23, SDL_ALPHA_OPAQUE);
+    if (view->options_choice == RESOLUTION) {
+        SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5-15, "Resolution");
+        if (view->resolution_choice == VGA) {
+            SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "640x480");
+        } else if (view->resolution_choice == SVGA) {
+            SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "800x600");
+        } else if (view->resolution_choice == HD) {
+            SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1280x720");
+        } else if (view->resolution_choice == XGA) {
+            SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1024x768");
+        } else if (view->resolution_choice == WXGA) {
+            SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1366x768");
+        } else if (view->resolution_choice == SXGA) {
+            SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "12801024");
+        } else if (view->resolution_choice == FHD) {
+            SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "1920x1080");
+        } else if (view->resolution_choice == QHD) {
+            SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5-15, "2560x1440");
+        }
+
+    } else if (view->options_choice == FULLSCREEN) {
+        SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5, "Fullscreen");
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5, "ON");
+        SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5, "OFF");
+        if (view->is_fullscreen == true) {
+            fullscreen_choice.x = 7*GAME_WIDTH/20 - 5;
+            fullscreen_choice.y = GAME_HEIGHT/5;
+        } else {
+            fullscreen_choice.x = 8*GAME_WIDTH/20 - 5;
+            fullscreen_choice.y = GAME_HEIGHT/5;
+        }
+
+    } else if (view->options_choice == PACING) {
+        SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+15, "Frame Rate");
+        draw_pacing_value(renderer, view->frame_pacing);
+
+    } else if (view->options_choice == AUDIO) {
+        SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+30, "Audio");
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+30, "ON");
+        SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+30, "OFF");
+        if (view->is_audio_enabled == true) {
+            audio_choice.x = 7*GAME_WIDTH/20 - 5;
+            audio_choice.y = GAME_HEIGHT/5+30;
+        } else {
+            audio_choice.x = 8*GAME_WIDTH/20 - 5;
+            audio_choice.y = GAME_HEIGHT/5+30;
+        }
+
+    } else if (view->options_choice == BALL_SPEED) {
+        SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+45, "Ball Speed");
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+45, "LOW");
+        SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+45, "MED");
+        SDL_RenderDebugText(renderer, 9*GAME_WIDTH/20, GAME_HEIGHT/5+45, "HIGH");
+        if (view->ball_speed_difficulty == B_LOW) {
+            ball_speed_choice.x = 7*GAME_WIDTH/20 - 5;
+            ball_speed_choice.y = GAME_HEIGHT/5+45;
+        } else if (view->ball_speed_difficulty == B_MEDIUM) {
+            ball_speed_choice.x = 8*GAME_WIDTH/20 - 5;
+            ball_speed_choice.y = GAME_HEIGHT/5+45;
+        } else if (view->ball_speed_difficulty == B_HIGH) {
+            ball_speed_choice.x = 9*GAME_WIDTH/20 - 5;
+            ball_speed_choice.y = GAME_HEIGHT/5+45;
+        }
+
+    } else if (view->options_choice == PADDLE_SPEED) {
+        SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+60, "Paddle Speed");
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+60, "LOW");
+        SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+60, "MED");
+        SDL_RenderDebugText(renderer, 9*GAME_WIDTH/20, GAME_HEIGHT/5+60, "HIGH");
+        if (view->paddle_speed_difficulty == P_LOW) {
+            paddle_speed_choice.x = 7*GAME_WIDTH/20 - 5;
+            paddle_speed_choice.y = GAME_HEIGHT/5+60;
+        } else if (view->paddle_speed_difficulty == P_MEDIUM) {
+            paddle_speed_choice.x = 8*GAME_WIDTH/20 - 5;
+            paddle_speed_choice.y = GAME_HEIGHT/5+60;
+        } else if (view->paddle_speed_difficulty == P_HIGH) {
+            paddle_speed_choice.x = 9*GAME_WIDTH/20 - 5;
+            paddle_speed_choice.y = GAME_HEIGHT/5+60;
+        }
+
+    } else if (view->options_choice == CPU_LEVEL) {
+        SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+75, "CPU");
+        SDL_RenderDebugText(renderer, 7*GAME_WIDTH/20, GAME_HEIGHT/5+75, "LOW");
+        SDL_RenderDebugText(renderer, 8*GAME_WIDTH/20, GAME_HEIGHT/5+75, "MED");
+        SDL_RenderDebugText(renderer, 9*GAME_WIDTH/20, GAME_HEIGHT/5+75, "HIGH");
+
+    } else if (view->options_choice == APPLY) {
+        SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+90, "APPLY");
+
+    } else if (view->options_choice == BACK) {
+        SDL_RenderDebugText(renderer, GAME_WIDTH/7, GAME_HEIGHT/5+100, "BACK");
+    }
+}
+
+void scene_render_main(SDL_Renderer *renderer, Menu menu_choice, bool show_play) {
+    if (!s_main_layer.valid || menu_choice != s_main_menu_choice || show_play != s_main_show_play) {
+        SDL_Texture *previous_target;
+        if (!begin_layer(renderer, &s_main_layer, &previous_target)) {
+            draw_main(renderer, menu_choice, show_play);
+            return;
+        }
+        draw_main(renderer, menu_choice, show_play);
+        end_layer(renderer, &s_main_layer, previous_target);
+        s_main_menu_choice = menu_choice;
+        s_main_show_play = show_play;
+    }
+    blit_layer(renderer, &s_main_layer);
+}
+
+void scene_render_config(SDL_Renderer *renderer, const ConfigView *view) {
+    if (!s_config_layer.valid || !same_config_view(view, &s_config_view)) {
+        SDL_Texture *previous_target;
+        if (!begin_layer(renderer, &s_config_layer, &previous_target)) {
+            draw_config(renderer, view);
+            return;
+        }
+        draw_config(renderer, view);
+        end_layer(renderer, &s_config_layer, previous_target);
+        s_config_view = *view;
+    }
+    blit_layer(renderer, &s_config_layer);
+}
+
+// Render digits 0-9 in white on transparent, left to right, into the HUD atlas
+static bool build_hud_atlas(SDL_Renderer *renderer) {
+    if (!s_hud.atlas) {
+        s_hud.atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                        10 * HUD_GLYPH_SIZE, HUD_GLYPH_SIZE);
+        if (!s_hud.atlas) {
+            return false;
+        }
+        SDL_SetTextureBlendMode(s_hud.atlas, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureScaleMode(s_hud.atlas, SDL_SCALEMODE_NEAREST);
+    }
+
+    SDL_Texture *previous_target = SDL_GetRenderTarget(renderer);
+    if (!SDL_SetRenderTarget(renderer, s_hud.atlas)) {
+        return false;
+    }
+    SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_TRANSPARENT);
+    SDL_RenderClear(renderer);
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
+    SDL_RenderDebugText(renderer, 0, 0, "0123456789");
+    SDL_SetRenderTarget(renderer, previous_target);
+
+    s_hud.atlas_valid = true;
+    return true;
+}
+
+// Add the quads for 'score' with its first digit at 'x', 'y'
+static void add_score_glyphs(int score, float x, float y, SDL_FColor color) {
+    int digits[HUD_MAX_DIGITS];
+    int count = 0;
+    do {
+        digits[count++] = score % 10;
+        score /= 10;
+    } while (score > 0 && count < HUD_MAX_DIGITS);
+
+    for (int i = count - 1; i >= 0; i--) {
+        const SDL_FRect glyph = {x, y, HUD_GLYPH_SIZE, HUD_GLYPH_SIZE};
+        const SDL_FRect uv = {digits[i] / 10.0f, 0, 1 / 10.0f, 1};
+        geometry_add_textured_rect(&s_hud.geometry, &glyph, &uv, color);
+        x += HUD_GLYPH_SIZE;
+    }
+}
+
+static void draw_scores(SDL_Renderer *renderer, int score_player, int score_cpu) {
+    TRACE_ZONE("score text");
+    if (!s_hud.atlas_valid && !build_hud_atlas(renderer)) {
+        // No target textures: format and draw the text every frame instead
+        SDL_SetRenderDrawColor(renderer, 151, 188, 98, SDL_ALPHA_OPAQUE);
+        SDL_RenderDebugTextFormat(renderer, GAME_WIDTH/4, 100, "%d", score_player);
+        SDL_RenderDebugTextFormat(renderer, 3*GAME_WIDTH/4, 100, "%d", score_cpu);
+        return;
+    }
+
+    if (!s_hud.geometry_valid || score_player != s_hud.score_player || score_cpu != s_hud.score_cpu) {
+        const SDL_FColor color = geometry_color(151, 188, 98, SDL_ALPHA_OPAQUE);
+        geometry_clear(&s_hud.geometry);
+        add_score_glyphs(SDL_max(score_player, 0), GAME_WIDTH/4, 100, color);
+        add_score_glyphs(SDL_max(score_cpu, 0), 3*GAME_WIDTH/4, 100, color);
+        s_hud.score_player = score_player;
+        s_hud.score_cpu = score_cpu;
+        s_hud.geometry_valid = true;
+    }
+    geometry_draw(&s_hud.geometry, renderer, s_hud.atlas);
+}
+
+void scene_render_game(SDL_Renderer *renderer, const GameView *view) {
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(renderer);
+    SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+
+    // Background, paddles, ball and partition all go out in one SDL_RenderGeometry() call
+    geometry_clear(&s_game_geometry);
+
+    // Background covering only viewport and not entire screen
+    const SDL_FRect background = {0, 0, GAME_WIDTH, GAME_HEIGHT};
+    geometry_add_rect(&s_game_geometry, &background, geometry_color(16, 24, 32, SDL_ALPHA_OPAQUE));
+
+    // Left and right edge of screen
+    const SDL_FColor paddle_color = geometry_color(242, 170, 76, SDL_ALPHA_OPAQUE);
+    const SDL_FRect paddle_player = {PADDLE_PLAYER_X, view->position_player_y, PADDLE_WIDTH, PADDLE_HEIGHT};
+    const SDL_FRect paddle_cpu = {PADDLE_CPU_X, view->position_cpu_y, PADDLE_WIDTH, PADDLE_HEIGHT};
+    geometry_add_rect(&s_game_geometry, &paddle_player, paddle_color);
+    geometry_add_rect(&s_game_geometry, &paddle_cpu, paddle_color);
+
+    const SDL_FRect ball = {view->position_ball_x, view->position_ball_y, BALL_SIZE, BALL_SIZE};
+    geometry_add_rect(&s_game_geometry, &ball, geometry_color(233, 75, 60, SDL_ALPHA_OPAQUE));
+
+    // Middle partition, one pixel every 10
+    const SDL_FColor partition_color = geometry_color(255, 255, 255, SDL_ALPHA_OPAQUE);
+    for (int i = 0; i < GAME_HEIGHT; i += 10) {
+        const SDL_FRect point = {GAME_WIDTH/2, (float) i, 1, 1};
+        geometry_add_rect(&s_game_geometry, &point, partition_color);
+    }
+
+    geometry_draw(&s_game_geometry, renderer, NULL);
+
+    // Display scores
+    draw_scores(renderer, view->score_player, view->score_cpu);
+}
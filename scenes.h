@@ -0,0 +1,73 @@
+/* Drawing of each screen, kept apart from input, audio and timing so the same code
+ * can be driven by the game and by pong_bench. All coordinates are in game units
+ * (GAME_WIDTH x GAME_HEIGHT); the renderer's logical presentation scales them.
+ */
+
+#ifndef SCENES_H
+#define SCENES_H
+
+#include <SDL3/SDL.h>
+#include "match.h"
+
+// Which window is being displayed (eg main menu or options menu)
+enum Window {MAIN = 0, CONFIG = 1, GAME = 2};
+
+// Choices in main menu
+enum Menu {PLAY = 0, OPTIONS = 1, QUIT = 2};
+
+// Choices in option menu
+enum Option {RESOLUTION = 0, FULLSCREEN = 1, PACING = 2, AUDIO = 3, BALL_SPEED = 4, PADDLE_SPEED = 5, CPU_LEVEL = 6, APPLY = 7, BACK = 8};
+
+// List of available resolutions
+enum Resolution {VGA = 0, SVGA = 1, HD = 2, XGA = 3, WXGA = 4, SXGA = 5, FHD = 6, QHD = 7};
+
+// Frame pacing modes (see pacing.h)
+enum FramePacing {F_VSYNC = 0, F_ADAPTIVE = 1, F_UNCAPPED = 2, F_CAP_30 = 3, F_CAP_60 = 4, F_CAP_144 = 5};
+
+// Ball speed levels
+enum BallSpeed {B_LOW = 0, B_MEDIUM = 1, B_HIGH = 2};
+
+// Paddle speed levels
+enum PaddleSpeed {P_LOW = 0, P_MEDIUM = 1, P_HIGH = 2};
+
+// CPU opponent levels (see match_set_cpu_level())
+enum CpuLevel {C_LOW = 0, C_MEDIUM = 1, C_HIGH = 2};
+
+// Everything the options menu shows
+typedef struct ConfigView {
+    Option options_choice;
+    Resolution resolution_choice;
+    bool is_fullscreen;
+    FramePacing frame_pacing;
+    bool is_audio_enabled;
+    BallSpeed ball_speed_difficulty;
+    PaddleSpeed paddle_speed_difficulty;
+    CpuLevel cpu_level;
+} ConfigView;
+
+// Where the match is drawn this frame (already interpolated between ticks)
+typedef struct GameView {
+    float position_player_y;
+    float position_cpu_y;
+    float position_ball_x;
+    float position_ball_y;
+    int score_player;
+    int score_cpu;
+} GameView;
+
+// Allocate what the scenes draw with; call once before rendering
+bool scene_init(void);
+void scene_quit(void);
+
+// Forget cached menu layers, eg after SDL_EVENT_RENDER_TARGETS_RESET lost their contents
+void scene_invalidate(void);
+
+/* Menus are cached in a texture each and only redrawn when their arguments change.
+   'show_play' is false during the off half of PLAY flashing after it was chosen. */
+void scene_render_main(SDL_Renderer *renderer, Menu menu_choice, bool show_play);
+
+void scene_render_config(SDL_Renderer *renderer, const ConfigView *view);
+
+void scene_render_game(SDL_Renderer *renderer, const GameView *view);
+
+#endif
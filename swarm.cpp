@@ -0,0 +1,276 @@
+#include "swarm.h"
+
+/* Hand out the next 'capacity' elements of the swarm allocation */
+template <typename T>
+static T *take_array(Uint8 **next, int capacity) {
+    T *array = (T *) *next;
+    *next += capacity * sizeof(T);
+    return array;
+}
+
+bool swarm_create(BallSwarm *swarm, int capacity, Uint64 seed) {
+    SDL_zerop(swarm);
+
+    // A multiple of 8 keeps every array on a 32 byte boundary
+    capacity = ((capacity + 7) / 8) * 8;
+    const size_t bytes = capacity * (8 * sizeof(float) + sizeof(int)) + (SWARM_GRID_CELLS + 1) * sizeof(int);
+    Uint8 *memory = (Uint8 *) SDL_aligned_alloc(32, bytes);
+    if (!memory) {
+        return false;
+    }
+    SDL_memset(memory, 0, bytes);
+
+    if (!geometry_create(&swarm->geometry, capacity)) {
+        SDL_aligned_free(memory);
+        return false;
+    }
+
+    swarm->capacity = capacity;
+    swarm->memory = memory;
+    swarm->rng_state = seed;
+
+    Uint8 *next = memory;
+    swarm->x = take_array<float>(&next, capacity);
+    swarm->y = take_array<float>(&next, capacity);
+    swarm->velocity_x = take_array<float>(&next, capacity);
+    swarm->velocity_y = take_array<float>(&next, capacity);
+    swarm->sorted_x = take_array<float>(&next, capacity);
+    swarm->sorted_y = take_array<float>(&next, capacity);
+    swarm->sorted_velocity_x = take_array<float>(&next, capacity);
+    swarm->sorted_velocity_y = take_array<float>(&next, capacity);
+    swarm->cell_of = take_array<int>(&next, capacity);
+    swarm->cell_start = take_array<int>(&next, SWARM_GRID_CELLS + 1);
+    return true;
+}
+
+void swarm_destroy(BallSwarm *swarm) {
+    geometry_destroy(&swarm->geometry);
+    SDL_aligned_free(swarm->memory);
+    SDL_zerop(swarm);
+}
+
+// Give ball 'i' a random speed and heading, never too steep to cross the court
+static void serve(BallSwarm *swarm, int i) {
+    const float speed = 150 + 200 * SDL_randf_r(&swarm->rng_state);
+    const float component_x = 0.3f + 0.4f * SDL_randf_r(&swarm->rng_state);
+    const float component_y = SDL_sqrtf(1 - component_x * component_x);
+    swarm->velocity_x[i] = speed * component_x * (SDL_rand_r(&swarm->rng_state, 2) ? 1 : -1);
+    swarm->velocity_y[i] = speed * component_y * (SDL_rand_r(&swarm->rng_state, 2) ? 1 : -1);
+}
+
+int swarm_spawn(BallSwarm *swarm, int count) {
+    count = SDL_min(count, swarm->capacity - swarm->count);
+
+    // Anywhere between the paddles; the first steps push apart any that overlap
+    const float x_min = PADDLE_PLAYER_X + PADDLE_WIDTH + SWARM_BALL_SIZE;
+    const float x_max = PADDLE_CPU_X - 2 * SWARM_BALL_SIZE;
+    for (int n = 0; n < count; n++) {
+        const int i = swarm->count++;
+        swarm->x[i] = x_min + (x_max - x_min) * SDL_randf_r(&swarm->rng_state);
+        swarm->y[i] = (GAME_HEIGHT - SWARM_BALL_SIZE) * SDL_randf_r(&swarm->rng_state);
+        serve(swarm, i);
+    }
+    return count;
+}
+
+static int grid_column(float x) {
+    return SDL_clamp((int) (x / SWARM_CELL_SIZE), 0, SWARM_GRID_COLUMNS - 1);
+}
+
+static int grid_row(float y) {
+    return SDL_clamp((int) (y / SWARM_CELL_SIZE), 0, SWARM_GRID_ROWS - 1);
+}
+
+static void swap_arrays(float **a, float **b) {
+    float *swapped = *a;
+    *a = *b;
+    *b = swapped;
+}
+
+/* Counting sort of the balls by grid cell, into the sorted_ arrays which then swap with
+   the live ones. Balls of a cell end up next to each other in memory, so the narrow
+   phase reads them in order rather than chasing indices across the whole pool. */
+static void sort_into_grid(BallSwarm *swarm) {
+    int *cell_start = swarm->cell_start;
+    SDL_memset(cell_start, 0, (SWARM_GRID_CELLS + 1) * sizeof(int));
+
+    for (int i = 0; i < swarm->count; i++) {
+        const int cell = grid_row(swarm->y[i]) * SWARM_GRID_COLUMNS + grid_column(swarm->x[i]);
+        swarm->cell_of[i] = cell;
+        cell_start[cell]++;
+    }
+
+    // Counts to the index of each cell's first ball
+    int total = 0;
+    for (int c = 0; c < SWARM_GRID_CELLS; c++) {
+        const int balls = cell_start[c];
+        cell_start[c] = total;
+        total += balls;
+    }
+
+    // Scattering advances each start to the next cell's, so shift them back afterwards
+    for (int i = 0; i < swarm->count; i++) {
+        const int to = cell_start[swarm->cell_of[i]]++;
+        swarm->sorted_x[to] = swarm->x[i];
+        swarm->sorted_y[to] = swarm->y[i];
+        swarm->sorted_velocity_x[to] = swarm->velocity_x[i];
+        swarm->sorted_velocity_y[to] = swarm->velocity_y[i];
+    }
+    for (int c = SWARM_GRID_CELLS; c > 0; c--) {
+        cell_start[c] = cell_start[c - 1];
+    }
+    cell_start[0] = 0;
+
+    swap_arrays(&swarm->x, &swarm->sorted_x);
+    swap_arrays(&swarm->y, &swarm->sorted_y);
+    swap_arrays(&swarm->velocity_x, &swarm->sorted_velocity_x);
+    swap_arrays(&swarm->velocity_y, &swarm->sorted_velocity_y);
+}
+
+/* Separate balls 'i' and 'j' if they overlap and, if they are closing in, bounce them:
+   between equal masses that swaps their velocities along the line joining the centres. */
+static void collide_balls(BallSwarm *swarm, int i, int j) {
+    const float dx = swarm->x[j] - swarm->x[i];
+    const float dy = swarm->y[j] - swarm->y[i];
+    const float distance_squared = dx * dx + dy * dy;
+    if (distance_squared >= SWARM_BALL_SIZE * SWARM_BALL_SIZE || distance_squared == 0) {
+        return;
+    }
+
+    const float distance = SDL_sqrtf(distance_squared);
+    const float normal_x = dx / distance;
+    const float normal_y = dy / distance;
+
+    const float push = (SWARM_BALL_SIZE - distance) * 0.5f;
+    swarm->x[i] -= normal_x * push;
+    swarm->y[i] -= normal_y * push;
+    swarm->x[j] += normal_x * push;
+    swarm->y[j] += normal_y * push;
+
+    const float closing = (swarm->velocity_x[j] - swarm->velocity_x[i]) * normal_x +
+                          (swarm->velocity_y[j] - swarm->velocity_y[i]) * normal_y;
+    if (closing < 0) {
+        swarm->velocity_x[i] += closing * normal_x;
+        swarm->velocity_y[i] += closing * normal_y;
+        swarm->velocity_x[j] -= closing * normal_x;
+        swarm->velocity_y[j] -= closing * normal_y;
+        swarm->ball_hits++;
+    }
+}
+
+// Test the balls of a cell against each other and against the following cells they may touch
+static void collide_cell(BallSwarm *swarm, int column, int row) {
+    const int c = row * SWARM_GRID_COLUMNS + column;
+    const int first = swarm->cell_start[c];
+    const int end = swarm->cell_start[c + 1];
+    if (first == end) {
+        return;
+    }
+
+    // Only half the neighbourhood, so each pair of cells is visited once
+    const int neighbours[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+    for (int i = first; i < end; i++) {
+        for (int j = i + 1; j < end; j++) {
+            collide_balls(swarm, i, j);
+        }
+        for (int n = 0; n < 4; n++) {
+            const int other_column = column + neighbours[n][0];
+            const int other_row = row + neighbours[n][1];
+            if (other_column < 0 || other_column >= SWARM_GRID_COLUMNS || other_row >= SWARM_GRID_ROWS) {
+                continue;
+            }
+            const int other = other_row * SWARM_GRID_COLUMNS + other_column;
+            for (int j = swarm->cell_start[other]; j < swarm->cell_start[other + 1]; j++) {
+                collide_balls(swarm, i, j);
+            }
+        }
+    }
+}
+
+/* Push every ball overlapping the paddle at (paddle_x, paddle_y) out along the axis it
+   overlaps least, and send it away from the paddle. Only the cells under the paddle are read. */
+static void collide_paddle(BallSwarm *swarm, float paddle_x, float paddle_y) {
+    const int column_min = grid_column(paddle_x - SWARM_BALL_SIZE);
+    const int column_max = grid_column(paddle_x + PADDLE_WIDTH);
+    const int row_min = grid_row(paddle_y - SWARM_BALL_SIZE);
+    const int row_max = grid_row(paddle_y + PADDLE_HEIGHT);
+
+    for (int row = row_min; row <= row_max; row++) {
+        const int first = swarm->cell_start[row * SWARM_GRID_COLUMNS + column_min];
+        const int end = swarm->cell_start[row * SWARM_GRID_COLUMNS + column_max + 1];
+        for (int i = first; i < end; i++) {
+            const float x = swarm->x[i];
+            const float y = swarm->y[i];
+            const float overlap_x = SDL_min(x + SWARM_BALL_SIZE, paddle_x + PADDLE_WIDTH) - SDL_max(x, paddle_x);
+            const float overlap_y = SDL_min(y + SWARM_BALL_SIZE, paddle_y + PADDLE_HEIGHT) - SDL_max(y, paddle_y);
+            if (overlap_x <= 0 || overlap_y <= 0) {
+                continue;
+            }
+
+            if (overlap_x <= overlap_y) {
+                if (x + SWARM_BALL_SIZE/2 < paddle_x + PADDLE_WIDTH/2) {
+                    swarm->x[i] = paddle_x - SWARM_BALL_SIZE;
+                    swarm->velocity_x[i] = -SDL_fabsf(swarm->velocity_x[i]);
+                } else {
+                    swarm->x[i] = paddle_x + PADDLE_WIDTH;
+                    swarm->velocity_x[i] = SDL_fabsf(swarm->velocity_x[i]);
+                }
+            } else {
+                if (y + SWARM_BALL_SIZE/2 < paddle_y + PADDLE_HEIGHT/2) {
+                    swarm->y[i] = paddle_y - SWARM_BALL_SIZE;
+                    swarm->velocity_y[i] = -SDL_fabsf(swarm->velocity_y[i]);
+                } else {
+                    swarm->y[i] = paddle_y + PADDLE_HEIGHT;
+                    swarm->velocity_y[i] = SDL_fabsf(swarm->velocity_y[i]);
+                }
+            }
+            swarm->paddle_hits++;
+        }
+    }
+}
+
+void swarm_step(BallSwarm *swarm, const Match *match, float dt) {
+    // Move, bounce off the top and bottom walls, and serve again from the centre once out
+    for (int i = 0; i < swarm->count; i++) {
+        swarm->x[i] += swarm->velocity_x[i] * dt;
+        swarm->y[i] += swarm->velocity_y[i] * dt;
+
+        if (swarm->y[i] < 0) {
+            swarm->y[i] = 0;
+            swarm->velocity_y[i] = SDL_fabsf(swarm->velocity_y[i]);
+        } else if (swarm->y[i] > GAME_HEIGHT - SWARM_BALL_SIZE) {
+            swarm->y[i] = GAME_HEIGHT - SWARM_BALL_SIZE;
+            swarm->velocity_y[i] = -SDL_fabsf(swarm->velocity_y[i]);
+        }
+
+        if (swarm->x[i] < -SWARM_BALL_SIZE || swarm->x[i] > GAME_WIDTH) {
+            swarm->x[i] = (GAME_WIDTH - SWARM_BALL_SIZE) / 2;
+            swarm->y[i] = (GAME_HEIGHT - SWARM_BALL_SIZE) * SDL_randf_r(&swarm->rng_state);
+            serve(swarm, i);
+        }
+    }
+
+    sort_into_grid(swarm);
+
+    for (int row = 0; row < SWARM_GRID_ROWS; row++) {
+        for (int column = 0; column < SWARM_GRID_COLUMNS; column++) {
+            collide_cell(swarm, column, row);
+        }
+    }
+
+    // Paddles last, so no ball is left inside one by the pushes between balls
+    collide_paddle(swarm, PADDLE_PLAYER_X, match->position_player_y);
+    collide_paddle(swarm, PADDLE_CPU_X, match->position_cpu_y);
+}
+
+void swarm_draw(BallSwarm *swarm, SDL_Renderer *renderer) {
+    const SDL_FColor color = geometry_color(233, 75, 60, SDL_ALPHA_OPAQUE);
+
+    geometry_clear(&swarm->geometry);
+    for (int i = 0; i < swarm->count; i++) {
+        const SDL_FRect rect = {swarm->x[i], swarm->y[i], SWARM_BALL_SIZE, SWARM_BALL_SIZE};
+        geometry_add_rect(&swarm->geometry, &rect, color);
+    }
+    geometry_draw(&swarm->geometry, renderer, NULL);
+}
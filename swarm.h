@@ -0,0 +1,66 @@
+/* Stress mode: thousands of extra balls sharing the court with a match. Balls live in a
+ * pool of structure-of-arrays, are spawned into it and never allocated one by one.
+ * Every step they are sorted into a uniform grid of cells two balls wide, so a ball
+ * is only tested against balls in its own and neighbouring cells, and each paddle only
+ * against the cells it covers. All balls are drawn with one SDL_RenderGeometry() call.
+ */
+
+#ifndef SWARM_H
+#define SWARM_H
+
+#include <SDL3/SDL.h>
+#include "geometry.h"
+#include "match.h"
+
+// Swarm balls are smaller than the match ball so that thousands fit on the court
+const float SWARM_BALL_SIZE = 4;
+
+// Grid cells are square and at least a ball wide, so touching balls are in adjacent cells
+const float SWARM_CELL_SIZE = 8;
+const int SWARM_GRID_COLUMNS = (int) (GAME_WIDTH / SWARM_CELL_SIZE);
+const int SWARM_GRID_ROWS = (int) (GAME_HEIGHT / SWARM_CELL_SIZE);
+const int SWARM_GRID_CELLS = SWARM_GRID_COLUMNS * SWARM_GRID_ROWS;
+
+typedef struct BallSwarm {
+    int count;          // Balls in play
+    int capacity;       // Balls the pool holds
+
+    // Top-left corner and velocity in px/s of each ball
+    float *x;
+    float *y;
+    float *velocity_x;
+    float *velocity_y;
+
+    /* Broadphase, rebuilt every step by counting sort: the arrays above are reordered by
+       cell, so the balls of cell c are cell_start[c] .. cell_start[c + 1] - 1 */
+    int *cell_of;       // Per ball
+    int *cell_start;    // SWARM_GRID_CELLS + 1 entries
+
+    // Where the sort writes the reordered balls before swapping them in
+    float *sorted_x;
+    float *sorted_y;
+    float *sorted_velocity_x;
+    float *sorted_velocity_y;
+
+    Uint64 rng_state;
+    void *memory;       // Single allocation backing the arrays above
+
+    Geometry geometry;  // One quad per ball
+
+    // Totals since creation
+    Uint64 ball_hits;   // Ball-ball bounces
+    Uint64 paddle_hits;
+} BallSwarm;
+
+bool swarm_create(BallSwarm *swarm, int capacity, Uint64 seed);
+void swarm_destroy(BallSwarm *swarm);
+
+// Add up to 'count' balls at random places between the paddles; returns how many fit in the pool
+int swarm_spawn(BallSwarm *swarm, int count);
+
+// Move every ball by 'dt' seconds, bouncing off walls, each other and the paddles of 'match'
+void swarm_step(BallSwarm *swarm, const Match *match, float dt);
+
+void swarm_draw(BallSwarm *swarm, SDL_Renderer *renderer);
+
+#endif
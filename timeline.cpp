@@ -0,0 +1,171 @@
+#include "timeline.h"
+
+void timeline_init(Timeline *timeline) {
+    SDL_zerop(timeline);
+    timeline->next_id = 1;
+}
+
+// Claim a free item, or NULL if the table is full
+static TimelineItem *add_item(Timeline *timeline, TimelineItemType type, Uint64 now_ns, Uint64 due_ns) {
+    for (int i = 0; i < TIMELINE_MAX_ITEMS; i++) {
+        TimelineItem *item = &timeline->items[i];
+        if (item->type == TIMELINE_FREE) {
+            SDL_zerop(item);
+            item->type = type;
+            item->id = timeline->next_id++;
+            item->start_ns = now_ns;
+            item->due_ns = due_ns;
+            timeline->count++;
+            return item;
+        }
+    }
+    SDL_Log("Timeline is full");
+    return NULL;
+}
+
+static void free_item(Timeline *timeline, TimelineItem *item) {
+    item->type = TIMELINE_FREE;
+    timeline->count--;
+}
+
+int timeline_after(Timeline *timeline, Uint64 now_ns, Uint64 delay_ns, TimelineAction action, void *userdata) {
+    TimelineItem *item = add_item(timeline, TIMELINE_ACTION, now_ns, now_ns + delay_ns);
+    if (!item) {
+        return -1;
+    }
+    item->action = action;
+    item->userdata = userdata;
+    return item->id;
+}
+
+int timeline_every(Timeline *timeline, Uint64 now_ns, Uint64 period_ns, TimelineAction action, void *userdata) {
+    TimelineItem *item = add_item(timeline, TIMELINE_ACTION, now_ns, now_ns + period_ns);
+    if (!item) {
+        return -1;
+    }
+    item->period_ns = period_ns;
+    item->action = action;
+    item->userdata = userdata;
+    return item->id;
+}
+
+int timeline_on_cue(Timeline *timeline, Uint64 now_ns, TimelineCue cue, Uint64 timeout_ns,
+                    TimelineAction action, void *userdata) {
+    TimelineItem *item = add_item(timeline, TIMELINE_ACTION, now_ns, now_ns + timeout_ns);
+    if (!item) {
+        return -1;
+    }
+    item->cue = cue;
+    item->action = action;
+    item->userdata = userdata;
+    return item->id;
+}
+
+int timeline_tween(Timeline *timeline, Uint64 now_ns, float *value, float to, Uint64 duration_ns, TimelineEasing easing) {
+    TimelineItem *item = add_item(timeline, TIMELINE_TWEEN, now_ns, now_ns + duration_ns);
+    if (!item) {
+        return -1;
+    }
+    item->value = value;
+    item->from = *value;
+    item->to = to;
+    item->easing = easing;
+    return item->id;
+}
+
+void timeline_cancel(Timeline *timeline, int id) {
+    for (int i = 0; i < TIMELINE_MAX_ITEMS; i++) {
+        TimelineItem *item = &timeline->items[i];
+        if (item->type != TIMELINE_FREE && item->id == id) {
+            free_item(timeline, item);
+            return;
+        }
+    }
+}
+
+static float ease(TimelineEasing easing, float t) {
+    if (easing == EASE_OUT_CUBIC) {
+        const float left = 1 - t;
+        return 1 - left * left * left;
+    }
+    return t;
+}
+
+void timeline_update(Timeline *timeline, Uint64 now_ns) {
+    if (timeline->count == 0) {
+        return;
+    }
+
+    // A cue that has come brings its action's deadline forward to now
+    for (int i = 0; i < TIMELINE_MAX_ITEMS; i++) {
+        TimelineItem *item = &timeline->items[i];
+        if (item->type == TIMELINE_ACTION && item->cue && item->due_ns > now_ns && item->cue(item->userdata)) {
+            item->due_ns = now_ns;
+        }
+    }
+
+    /* Run due actions one at a time, earliest first. Each item is updated before its
+       action runs, as the action may schedule or cancel others (or itself). */
+    for (;;) {
+        TimelineItem *next = NULL;
+        for (int i = 0; i < TIMELINE_MAX_ITEMS; i++) {
+            TimelineItem *item = &timeline->items[i];
+            if (item->type == TIMELINE_ACTION && item->due_ns <= now_ns && (!next || item->due_ns < next->due_ns)) {
+                next = item;
+            }
+        }
+        if (!next) {
+            break;
+        }
+
+        const TimelineAction action = next->action;
+        void *userdata = next->userdata;
+        if (next->period_ns > 0) {
+            // Missed periods (eg a stalled frame) are skipped rather than run in a burst
+            next->due_ns += next->period_ns;
+            if (next->due_ns <= now_ns) {
+                next->due_ns = now_ns + next->period_ns;
+            }
+        } else {
+            free_item(timeline, next);
+        }
+        action(userdata);
+    }
+
+    for (int i = 0; i < TIMELINE_MAX_ITEMS; i++) {
+        TimelineItem *item = &timeline->items[i];
+        if (item->type != TIMELINE_TWEEN) {
+            continue;
+        }
+        if (now_ns >= item->due_ns) {
+            *item->value = item->to;
+            free_item(timeline, item);
+            continue;
+        }
+        const float t = (float) (now_ns - item->start_ns) / (float) (item->due_ns - item->start_ns);
+        *item->value = item->from + (item->to - item->from) * ease(item->easing, t);
+    }
+}
+
+bool timeline_active(const Timeline *timeline) {
+    return timeline->count > 0;
+}
+
+Uint64 timeline_next_due(const Timeline *timeline, Uint64 now_ns) {
+    Uint64 next = 0;
+    for (int i = 0; i < TIMELINE_MAX_ITEMS; i++) {
+        const TimelineItem *item = &timeline->items[i];
+        Uint64 due = item->due_ns;
+        if (item->type == TIMELINE_FREE) {
+            continue;
+        } else if (item->type == TIMELINE_TWEEN) {
+            due = now_ns;   // Moves every frame
+        } else if (item->cue) {
+            due = SDL_min(due, now_ns + TIMELINE_CUE_POLL_NS);
+        }
+        if (next == 0 || due < next) {
+            next = due;
+        }
+    }
+    return next;
+}
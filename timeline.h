@@ -0,0 +1,87 @@
+/* Timeline: delayed and repeating actions, actions waiting on a cue, and tweens of a
+ * float, all timed by SDL_GetTicksNS() rather than by counting frames, so they happen
+ * at the same wall-clock time at any frame rate. A cue is a condition polled on each
+ * update, eg a sound having played to its end, with a deadline in case it never comes.
+ * Everything lives in a fixed table; with nothing scheduled an update does nothing.
+ */
+
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <SDL3/SDL.h>
+
+const int TIMELINE_MAX_ITEMS = 16;
+
+// How often a cue is polled while the caller is otherwise idle (see timeline_next_due())
+const Uint64 TIMELINE_CUE_POLL_NS = 4 * SDL_NS_PER_MS;
+
+// Runs on the thread calling timeline_update()
+typedef void (*TimelineAction)(void *userdata);
+typedef bool (*TimelineCue)(void *userdata);
+
+enum TimelineEasing {
+    EASE_LINEAR = 0,
+    EASE_OUT_CUBIC      // Fast start, gentle landing
+};
+
+enum TimelineItemType {
+    TIMELINE_FREE = 0,
+    TIMELINE_ACTION,
+    TIMELINE_TWEEN
+};
+
+typedef struct TimelineItem {
+    TimelineItemType type;
+    int id;
+    Uint64 start_ns;
+    Uint64 due_ns;              // When an action runs, or a tween ends
+
+    // Actions
+    Uint64 period_ns;           // Repeats this often; 0 runs once
+    TimelineCue cue;            // Runs once this is true, or at due_ns at the latest
+    TimelineAction action;
+    void *userdata;
+
+    // Tweens
+    float *value;
+    float from;
+    float to;
+    TimelineEasing easing;
+} TimelineItem;
+
+typedef struct Timeline {
+    TimelineItem items[TIMELINE_MAX_ITEMS];
+    int count;                  // Items in use
+    int next_id;
+} Timeline;
+
+void timeline_init(Timeline *timeline);
+
+/* Each of these returns an id for timeline_cancel(), or -1 if the table is full.
+   'now_ns' is the current SDL_GetTicksNS(). */
+
+// Run 'action' once, 'delay_ns' from now
+int timeline_after(Timeline *timeline, Uint64 now_ns, Uint64 delay_ns, TimelineAction action, void *userdata);
+
+// Run 'action' every 'period_ns', the first time one period from now
+int timeline_every(Timeline *timeline, Uint64 now_ns, Uint64 period_ns, TimelineAction action, void *userdata);
+
+// Run 'action' once 'cue' is true, or 'timeout_ns' from now if it hasn't been by then
+int timeline_on_cue(Timeline *timeline, Uint64 now_ns, TimelineCue cue, Uint64 timeout_ns,
+                    TimelineAction action, void *userdata);
+
+// Move '*value' from what it is now to 'to' over 'duration_ns'
+int timeline_tween(Timeline *timeline, Uint64 now_ns, float *value, float to, Uint64 duration_ns, TimelineEasing easing);
+
+// Forget an item; a tween stays wherever it had got to
+void timeline_cancel(Timeline *timeline, int id);
+
+// Run what is due at 'now_ns', earliest first, and move the tweens
+void timeline_update(Timeline *timeline, Uint64 now_ns);
+
+bool timeline_active(const Timeline *timeline);
+
+// When timeline_update() next has something to do; 0 if nothing is scheduled
+Uint64 timeline_next_due(const Timeline *timeline, Uint64 now_ns);
+
+#endif
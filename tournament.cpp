@@ -0,0 +1,426 @@
+#include "tournament.h"
+#include "match.h"
+#include <atomic>
+
+/* Usage:
+ *   pong --tournament [--ball-speed LIST] [--paddle-speed LIST] [--cpu-speed LIST]
+ *                     [--matches N] [--points N] [--seed S] [--dt SECONDS]
+ *                     [--threads N] [--out FILE] [--cpu-level L]
+ *
+ * Each LIST is comma separated, eg '--ball-speed 0.3,0.6,1.0'. Every combination of
+ * the three lists is one config, and each config plays --matches matches. Match i
+ * uses the same seed under every config so configs are compared on equal serves.
+ * Results go to --out (default tournament.csv), one CSV row per config. --cpu-level
+ * (0 to 2) has every config play the predicting CPU instead of the ping-pong one.
+ *
+ * Scheduling: every match is a task. Tasks start split evenly over the workers as
+ * contiguous ranges; a worker takes from the front of its own range and, once that
+ * is empty, steals the back half of someone else's. Each worker adds its results
+ * into its own per-config totals, which are only summed after all threads finish,
+ * so workers never share a lock or a written cache line.
+ */
+
+// Most values accepted on one sweep axis
+static const int TOURNAMENT_MAX_VALUES = 16;
+
+typedef struct SweepAxis {
+    float values[TOURNAMENT_MAX_VALUES];
+    int count;
+} SweepAxis;
+
+typedef struct TournamentOptions {
+    SweepAxis ball_speed;
+    SweepAxis paddle_speed;
+    SweepAxis cpu_speed;
+    int matches;        // Matches per config
+    int points;
+    Uint64 seed;
+    float dt;
+    int threads;
+    const char *out;
+    int cpu_level;      // -1 for CPU_PING_PONG
+} TournamentOptions;
+
+// Totals for one config, as gathered by one worker
+typedef struct ConfigStats {
+    Uint64 matches;
+    Uint64 player_wins;
+    Uint64 cpu_wins;
+    Uint64 unfinished;
+    Uint64 points_player;
+    Uint64 points_cpu;
+    Uint64 returns;
+    Uint64 ticks;
+    int longest_rally;
+} ConfigStats;
+
+typedef struct Tournament Tournament;
+
+// Own cache line each, so one worker popping doesn't slow down another
+struct alignas(64) Worker {
+    // Remaining tasks: first in the low 32 bits, one past the last in the high 32 bits
+    std::atomic<Uint64> range;
+
+    ConfigStats *stats;     // One per config, written only by this worker
+    Uint64 rng_state;       // For picking steal victims
+    int executed;
+    int steals;
+    Tournament *tournament;
+    SDL_Thread *thread;
+};
+
+struct Tournament {
+    const TournamentOptions *options;
+    MatchConfig *configs;
+    int config_count;
+    Worker *workers;
+    int worker_count;
+};
+
+bool tournament_requested(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (SDL_strcmp(argv[i], "--tournament") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_axis(const char *arg, const char *value, SweepAxis *axis) {
+    axis->count = 0;
+    const char *next = value;
+    while (*next) {
+        if (axis->count == TOURNAMENT_MAX_VALUES) {
+            SDL_Log("'%s' takes at most %d values", arg, TOURNAMENT_MAX_VALUES);
+            return false;
+        }
+        char *end = NULL;
+        axis->values[axis->count++] = (float) SDL_strtod(next, &end);
+        if (end == next || (*end != ',' && *end != '\0')) {
+            SDL_Log("Bad value list '%s' for '%s'", value, arg);
+            return false;
+        }
+        next = (*end == ',') ? end + 1 : end;
+    }
+    return axis->count > 0;
+}
+
+static bool parse_options(int argc, char *argv[], TournamentOptions *options) {
+    MatchConfig defaults;
+    match_default_config(&defaults);
+
+    options->ball_speed.values[0] = defaults.ball_speed_multiplier;
+    options->ball_speed.count = 1;
+    options->paddle_speed.values[0] = defaults.paddle_speed_multiplier;
+    options->paddle_speed.count = 1;
+    options->cpu_speed.values[0] = defaults.cpu_speed;
+    options->cpu_speed.count = 1;
+    options->matches = 1000;
+    options->points = 11;
+    options->seed = 1;
+    options->dt = SIM_DT;
+    options->threads = SDL_GetNumLogicalCPUCores();
+    options->out = "tournament.csv";
+    options->cpu_level = -1;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (SDL_strcmp(arg, "--tournament") == 0) {
+            continue;
+        }
+        if (value == NULL) {
+            SDL_Log("Missing value for '%s'", arg);
+            return false;
+        }
+
+        if (SDL_strcmp(arg, "--ball-speed") == 0) {
+            if (!parse_axis(arg, value, &options->ball_speed)) {
+                return false;
+            }
+        } else if (SDL_strcmp(arg, "--paddle-speed") == 0) {
+            if (!parse_axis(arg, value, &options->paddle_speed)) {
+                return false;
+            }
+        } else if (SDL_strcmp(arg, "--cpu-speed") == 0) {
+            if (!parse_axis(arg, value, &options->cpu_speed)) {
+                return false;
+            }
+        } else if (SDL_strcmp(arg, "--matches") == 0) {
+            options->matches = SDL_atoi(value);
+        } else if (SDL_strcmp(arg, "--points") == 0) {
+            options->points = SDL_atoi(value);
+        } else if (SDL_strcmp(arg, "--seed") == 0) {
+            options->seed = SDL_strtoull(value, NULL, 0);
+        } else if (SDL_strcmp(arg, "--dt") == 0) {
+            options->dt = (float) SDL_atof(value);
+        } else if (SDL_strcmp(arg, "--threads") == 0) {
+            options->threads = SDL_atoi(value);
+        } else if (SDL_strcmp(arg, "--out") == 0) {
+            options->out = value;
+        } else if (SDL_strcmp(arg, "--cpu-level") == 0) {
+            options->cpu_level = SDL_atoi(value);
+            if (options->cpu_level < 0 || options->cpu_level >= MATCH_CPU_LEVELS) {
+                SDL_Log("--cpu-level must be between 0 and %d", MATCH_CPU_LEVELS - 1);
+                return false;
+            }
+        } else {
+            SDL_Log("Unknown tournament option '%s'", arg);
+            return false;
+        }
+        i++;
+    }
+
+    if (options->matches <= 0 || options->points <= 0 || options->dt <= 0 || options->threads <= 0) {
+        SDL_Log("--matches, --points, --dt and --threads must be positive");
+        return false;
+    }
+    return true;
+}
+
+static Uint64 pack_range(Uint32 begin, Uint32 end) {
+    return ((Uint64) end << 32) | begin;
+}
+
+/* Take the next task from the front of our own range */
+static bool pop_task(Worker *worker, Uint32 *task) {
+    Uint64 range = worker->range.load(std::memory_order_acquire);
+    for (;;) {
+        const Uint32 begin = (Uint32) range;
+        const Uint32 end = (Uint32) (range >> 32);
+        if (begin >= end) {
+            return false;
+        }
+        if (worker->range.compare_exchange_weak(range, pack_range(begin + 1, end), std::memory_order_acq_rel)) {
+            *task = begin;
+            return true;
+        }
+    }
+}
+
+/* Move the back half of 'victim's range into our own (currently empty) range */
+static bool steal_tasks(Worker *thief, Worker *victim) {
+    Uint64 range = victim->range.load(std::memory_order_acquire);
+    for (;;) {
+        const Uint32 begin = (Uint32) range;
+        const Uint32 end = (Uint32) (range >> 32);
+        if (begin >= end) {
+            return false;
+        }
+        const Uint32 take = (end - begin + 1) / 2;
+        if (victim->range.compare_exchange_weak(range, pack_range(begin, end - take), std::memory_order_acq_rel)) {
+            thief->range.store(pack_range(end - take, end), std::memory_order_release);
+            thief->steals++;
+            return true;
+        }
+    }
+}
+
+static void run_task(Worker *worker, Uint32 task) {
+    const Tournament *tournament = worker->tournament;
+    const TournamentOptions *options = tournament->options;
+    const int config_index = task / options->matches;
+    const int match_index = task % options->matches;
+
+    Match match;
+    match_init(&match, &tournament->configs[config_index], match_seed(options->seed, match_index));
+
+    MatchSummary summary;
+    match_play(&match, options->points, options->dt, (Uint64) (MATCH_PLAY_MAX_SECONDS / options->dt), &summary);
+
+    ConfigStats *stats = &worker->stats[config_index];
+    stats->matches++;
+    stats->points_player += match.score_player;
+    stats->points_cpu += match.score_cpu;
+    stats->returns += summary.returns;
+    stats->ticks += summary.ticks;
+    stats->longest_rally = SDL_max(stats->longest_rally, summary.longest_rally);
+    if (match.score_player >= options->points) {
+        stats->player_wins++;
+    } else if (match.score_cpu >= options->points) {
+        stats->cpu_wins++;
+    } else {
+        stats->unfinished++;
+    }
+    worker->executed++;
+}
+
+static int SDLCALL worker_main(void *data) {
+    Worker *worker = (Worker *) data;
+    Tournament *tournament = worker->tournament;
+
+    for (;;) {
+        Uint32 task;
+        if (pop_task(worker, &task)) {
+            run_task(worker, task);
+            continue;
+        }
+
+        // Own range is empty; look for work elsewhere, starting at a random worker
+        bool stole = false;
+        const int first = SDL_rand_r(&worker->rng_state, tournament->worker_count);
+        for (int n = 0; n < tournament->worker_count && !stole; n++) {
+            Worker *victim = &tournament->workers[(first + n) % tournament->worker_count];
+            if (victim != worker) {
+                stole = steal_tasks(worker, victim);
+            }
+        }
+        // Nobody has work left (tasks are never added), so we're done
+        if (!stole) {
+            break;
+        }
+    }
+    return 0;
+}
+
+static bool write_results(const Tournament *tournament, const ConfigStats *totals) {
+    SDL_IOStream *out = SDL_IOFromFile(tournament->options->out, "w");
+    if (!out) {
+        SDL_Log("Couldn't open '%s': %s", tournament->options->out, SDL_GetError());
+        return false;
+    }
+
+    SDL_IOprintf(out, "ball_speed,paddle_speed,cpu_speed,matches,player_wins,cpu_wins,unfinished,"
+                      "player_win_rate,points_player,points_cpu,returns_per_point,longest_rally,sim_seconds\n");
+    for (int c = 0; c < tournament->config_count; c++) {
+        const MatchConfig *config = &tournament->configs[c];
+        const ConfigStats *stats = &totals[c];
+        const Uint64 points = stats->points_player + stats->points_cpu;
+        SDL_IOprintf(out, "%g,%g,%g,%" SDL_PRIu64 ",%" SDL_PRIu64 ",%" SDL_PRIu64 ",%" SDL_PRIu64 ",%.4f,%"
+                          SDL_PRIu64 ",%" SDL_PRIu64 ",%.3f,%d,%.1f\n",
+                     config->ball_speed_multiplier, config->paddle_speed_multiplier, config->cpu_speed,
+                     stats->matches, stats->player_wins, stats->cpu_wins, stats->unfinished,
+                     stats->matches ? (double) stats->player_wins / stats->matches : 0.0,
+                     stats->points_player, stats->points_cpu,
+                     points ? (double) stats->returns / points : 0.0,
+                     stats->longest_rally, stats->ticks * tournament->options->dt);
+    }
+
+    return SDL_CloseIO(out);
+}
+
+SDL_AppResult tournament_run(int argc, char *argv[]) {
+    TournamentOptions options;
+    if (!parse_options(argc, argv, &options)) {
+        return SDL_APP_FAILURE;
+    }
+
+    Tournament tournament;
+    tournament.options = &options;
+    tournament.config_count = options.ball_speed.count * options.paddle_speed.count * options.cpu_speed.count;
+    tournament.worker_count = options.threads;
+
+    const Uint64 task_count = (Uint64) tournament.config_count * options.matches;
+    if (task_count > 0xFFFFFFFFu) {
+        SDL_Log("Too many matches in one tournament");
+        return SDL_APP_FAILURE;
+    }
+
+    tournament.configs = (MatchConfig *) SDL_malloc(tournament.config_count * sizeof(MatchConfig));
+    ConfigStats *totals = (ConfigStats *) SDL_calloc(tournament.config_count, sizeof(ConfigStats));
+    tournament.workers = new Worker[tournament.worker_count];
+    if (!tournament.configs || !totals) {
+        SDL_free(tournament.configs);
+        SDL_free(totals);
+        delete[] tournament.workers;
+        return SDL_APP_FAILURE;
+    }
+
+    int c = 0;
+    for (int b = 0; b < options.ball_speed.count; b++) {
+        for (int p = 0; p < options.paddle_speed.count; p++) {
+            for (int s = 0; s < options.cpu_speed.count; s++) {
+                match_default_config(&tournament.configs[c]);
+                if (options.cpu_level >= 0) {
+                    match_set_cpu_level(&tournament.configs[c], options.cpu_level);
+                }
+                tournament.configs[c].ball_speed_multiplier = options.ball_speed.values[b];
+                tournament.configs[c].paddle_speed_multiplier = options.paddle_speed.values[p];
+                tournament.configs[c].cpu_speed = options.cpu_speed.values[s];
+                c++;
+            }
+        }
+    }
+
+    // Hand each worker an equal contiguous slice of all tasks
+    for (int w = 0; w < tournament.worker_count; w++) {
+        Worker *worker = &tournament.workers[w];
+        const Uint32 begin = (Uint32) (task_count * w / tournament.worker_count);
+        const Uint32 end = (Uint32) (task_count * (w + 1) / tournament.worker_count);
+        worker->range.store(pack_range(begin, end));
+        // Cache line aligned so neighbouring workers' totals never share a line
+        worker->stats = (ConfigStats *) SDL_aligned_alloc(64, tournament.config_count * sizeof(ConfigStats));
+        if (worker->stats) {
+            SDL_memset(worker->stats, 0, tournament.config_count * sizeof(ConfigStats));
+        }
+        worker->rng_state = match_seed(options.seed, w);
+        worker->executed = 0;
+        worker->steals = 0;
+        worker->tournament = &tournament;
+        worker->thread = NULL;
+    }
+
+    SDL_Log("Tournament: %d configs x %d matches to %d points on %d threads",
+            tournament.config_count, options.matches, options.points, tournament.worker_count);
+
+    const Uint64 start = SDL_GetTicksNS();
+    for (int w = 0; w < tournament.worker_count; w++) {
+        Worker *worker = &tournament.workers[w];
+        if (worker->stats) {
+            worker->thread = SDL_CreateThread(worker_main, "tournament", worker);
+        }
+        if (!worker->thread) {
+            SDL_Log("Couldn't start worker %d: %s", w, SDL_GetError());
+        }
+    }
+    // Workers that failed to start still own tasks; the others will steal them
+    for (int w = 0; w < tournament.worker_count; w++) {
+        SDL_WaitThread(tournament.workers[w].thread, NULL);
+    }
+    const double seconds = (double) (SDL_GetTicksNS() - start) / SDL_NS_PER_SECOND;
+
+    Uint64 matches_played = 0;
+    for (int w = 0; w < tournament.worker_count; w++) {
+        const Worker *worker = &tournament.workers[w];
+        if (!worker->stats) {
+            continue;
+        }
+        for (c = 0; c < tournament.config_count; c++) {
+            ConfigStats *total = &totals[c];
+            const ConfigStats *stats = &worker->stats[c];
+            total->matches += stats->matches;
+            total->player_wins += stats->player_wins;
+            total->cpu_wins += stats->cpu_wins;
+            total->unfinished += stats->unfinished;
+            total->points_player += stats->points_player;
+            total->points_cpu += stats->points_cpu;
+            total->returns += stats->returns;
+            total->ticks += stats->ticks;
+            total->longest_rally = SDL_max(total->longest_rally, stats->longest_rally);
+        }
+        matches_played += worker->executed;
+        SDL_Log("Worker %d: %d matches, %d steals", w, worker->executed, worker->steals);
+    }
+
+    SDL_AppResult result = SDL_APP_SUCCESS;
+    if (matches_played != task_count) {
+        SDL_Log("Only %" SDL_PRIu64 " of %" SDL_PRIu64 " matches were played", matches_played, task_count);
+        result = SDL_APP_FAILURE;
+    }
+    if (!write_results(&tournament, totals)) {
+        result = SDL_APP_FAILURE;
+    }
+    if (seconds > 0) {
+        SDL_Log("%" SDL_PRIu64 " matches in %.3f s (%.0f matches/s), results in '%s'",
+                matches_played, seconds, matches_played / seconds, options.out);
+    }
+
+    for (int w = 0; w < tournament.worker_count; w++) {
+        SDL_aligned_free(tournament.workers[w].stats);
+    }
+    delete[] tournament.workers;
+    SDL_free(totals);
+    SDL_free(tournament.configs);
+    return result;
+}
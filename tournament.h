@@ -0,0 +1,16 @@
+/* Tournament runner: play thousands of independent matches for every point of a
+ * difficulty sweep grid, spread over all cores, and write one results file.
+ */
+
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <SDL3/SDL.h>
+
+// True if the command line asks for a tournament
+bool tournament_requested(int argc, char *argv[]);
+
+// Run the tournament described by the command line
+SDL_AppResult tournament_run(int argc, char *argv[]);
+
+#endif
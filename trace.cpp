@@ -0,0 +1,140 @@
+#include "trace.h"
+
+#ifdef PONG_TRACE
+
+#include <atomic>
+
+typedef struct TraceRecord {
+    const char *name;
+    Uint64 start_ns;
+    Uint64 end_ns;
+} TraceRecord;
+
+/* Only the owning thread writes a buffer. It fills the next record, then publishes it by
+   bumping 'written'; a dump copies records behind that and afterwards drops any the
+   owner may have started overwriting in the meantime. */
+typedef struct TraceBuffer {
+    TraceRecord records[TRACE_BUFFER_ZONES];
+    std::atomic<Uint64> written;        // Records ever written
+    std::atomic<const char *> name;
+} TraceBuffer;
+
+// Buffers live until exit, so zones of threads that have finished still get dumped
+static std::atomic<TraceBuffer *> s_buffers[TRACE_MAX_THREADS];
+static std::atomic<int> s_buffer_count;
+static thread_local TraceBuffer *t_buffer = NULL;
+static thread_local bool t_untraced = false;     // No buffer was left for this thread
+
+static TraceBuffer *thread_buffer(void) {
+    if (t_buffer || t_untraced) {
+        return t_buffer;
+    }
+    const int index = s_buffer_count.fetch_add(1);
+    if (index >= TRACE_MAX_THREADS) {
+        SDL_Log("More than %d traced threads; not tracing this one", TRACE_MAX_THREADS);
+        t_untraced = true;
+        return NULL;
+    }
+    TraceBuffer *buffer = new TraceBuffer();
+    s_buffers[index].store(buffer, std::memory_order_release);
+    t_buffer = buffer;
+    return buffer;
+}
+
+void trace_thread_name(const char *name) {
+    TraceBuffer *buffer = thread_buffer();
+    if (buffer) {
+        buffer->name.store(name, std::memory_order_release);
+    }
+}
+
+void trace_record(const char *name, Uint64 start_ns, Uint64 end_ns) {
+    TraceBuffer *buffer = thread_buffer();
+    if (!buffer) {
+        return;
+    }
+    const Uint64 written = buffer->written.load(std::memory_order_relaxed);
+    TraceRecord *record = &buffer->records[written & (TRACE_BUFFER_ZONES - 1)];
+    record->name = name;
+    record->start_ns = start_ns;
+    record->end_ns = end_ns;
+    buffer->written.store(written + 1, std::memory_order_release);
+}
+
+// Write one thread's zones; 'copy' has room for a whole buffer
+static bool dump_buffer(SDL_IOStream *io, int tid, TraceBuffer *buffer, TraceRecord *copy, bool *first) {
+    const Uint64 end = buffer->written.load(std::memory_order_acquire);
+    const Uint64 begin = end > TRACE_BUFFER_ZONES ? end - TRACE_BUFFER_ZONES : 0;
+    for (Uint64 i = begin; i < end; i++) {
+        copy[i - begin] = buffer->records[i & (TRACE_BUFFER_ZONES - 1)];
+    }
+    // The record after the last published one may be half written too
+    const Uint64 now_written = buffer->written.load(std::memory_order_acquire);
+    const Uint64 valid = now_written + 1 > TRACE_BUFFER_ZONES ? now_written + 1 - TRACE_BUFFER_ZONES : 0;
+
+    const char *name = buffer->name.load(std::memory_order_acquire);
+    if (name) {
+        SDL_IOprintf(io, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                     *first ? "" : ",\n", tid, name);
+    } else {
+        SDL_IOprintf(io, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                     *first ? "" : ",\n", tid, tid);
+    }
+    *first = false;
+
+    for (Uint64 i = SDL_max(begin, valid); i < end; i++) {
+        const TraceRecord *record = &copy[i - begin];
+        // Chrome traces count in microseconds
+        if (SDL_IOprintf(io, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                         record->name, tid, (double) record->start_ns / SDL_NS_PER_US,
+                         (double) (record->end_ns - record->start_ns) / SDL_NS_PER_US) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool trace_dump(const char *path) {
+    SDL_IOStream *io = SDL_IOFromFile(path, "w");
+    if (!io) {
+        SDL_Log("Couldn't open %s: %s", path, SDL_GetError());
+        return false;
+    }
+    TraceRecord *copy = (TraceRecord *) SDL_malloc(TRACE_BUFFER_ZONES * sizeof(TraceRecord));
+    if (!copy) {
+        SDL_CloseIO(io);
+        return false;
+    }
+
+    bool ok = SDL_IOprintf(io, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n") > 0;
+    bool first = true;
+    const int count = SDL_min(s_buffer_count.load(), TRACE_MAX_THREADS);
+    for (int i = 0; i < count && ok; i++) {
+        TraceBuffer *buffer = s_buffers[i].load(std::memory_order_acquire);
+        // Claimed but not stored yet by a thread just starting up
+        if (buffer) {
+            ok = dump_buffer(io, i + 1, buffer, copy, &first);
+        }
+    }
+    ok = ok && SDL_IOprintf(io, "\n]}\n") > 0;
+    SDL_free(copy);
+    if (!SDL_CloseIO(io) || !ok) {
+        SDL_Log("Couldn't write %s: %s", path, SDL_GetError());
+        return false;
+    }
+    SDL_Log("Wrote trace of %d threads to %s", count, path);
+    return true;
+}
+
+#else
+
+void trace_thread_name(const char *name) {
+    (void) name;
+}
+
+bool trace_dump(const char *path) {
+    SDL_Log("Built without PONG_TRACE; no trace to write to %s", path);
+    return false;
+}
+
+#endif
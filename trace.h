@@ -0,0 +1,52 @@
+/* Trace zones: TRACE_ZONE("name") times the rest of the enclosing scope, and
+ * trace_dump() writes the most recent zones of every thread as Chrome trace JSON, for
+ * chrome://tracing or ui.perfetto.dev. Each thread records into a ring of its own that
+ * only it writes, so a zone costs two clock reads and a store, with no lock. The ring
+ * keeps the last TRACE_BUFFER_ZONES zones and overwrites older ones.
+ *
+ * TRACE_SPAN() records a zone from times the caller has already taken.
+ *
+ * Zones are only compiled in when PONG_TRACE is defined (Debug builds, or the PONG_TRACE
+ * CMake option); otherwise TRACE_ZONE() is empty and trace_dump() only says so.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <SDL3/SDL.h>
+
+const int TRACE_MAX_THREADS = 16;
+const int TRACE_BUFFER_ZONES = 1 << 16;    // A power of two
+
+// Name the calling thread in dumps; threads that don't are called "thread N"
+void trace_thread_name(const char *name);
+
+// Write every thread's buffered zones to 'path'; false if it couldn't
+bool trace_dump(const char *path);
+
+#ifdef PONG_TRACE
+
+// 'name' must outlive the trace, eg a string literal
+void trace_record(const char *name, Uint64 start_ns, Uint64 end_ns);
+
+struct TraceZone {
+    const char *name;
+    Uint64 start_ns;
+
+    explicit TraceZone(const char *zone_name) : name(zone_name), start_ns(SDL_GetTicksNS()) {}
+    ~TraceZone() { trace_record(name, start_ns, SDL_GetTicksNS()); }
+};
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_JOIN(trace_zone_, __LINE__)(name)
+#define TRACE_SPAN(name, start_ns, end_ns) trace_record(name, start_ns, end_ns)
+
+#else
+
+#define TRACE_ZONE(name) ((void) 0)
+#define TRACE_SPAN(name, start_ns, end_ns) ((void) 0)
+
+#endif
+
+#endif